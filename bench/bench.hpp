@@ -0,0 +1,39 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+/**
+ * Host benchmarks of the library code paths. measure() repeats a call until it ran for at
+ * least min_ms and returns the time per call. The numbers compare variants on the machine
+ * that runs them, they are not AVR or ESP32 timings.
+ */
+
+namespace bench
+{
+  // keeps the compiler from dropping work whose result is not read
+  inline void keep(const void* p)
+  {
+    asm volatile("" : : "g"(p) : "memory");
+  }
+
+  // ns per call
+  template <typename F>
+  double measure(F fn, uint32_t min_ms = 200u)
+  {
+    using clock = std::chrono::steady_clock;
+    for (uint32_t calls = 1;; calls *= 2)
+    {
+      clock::time_point start = clock::now();
+      for (uint32_t i = 0; i < calls; ++i) fn();
+      double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+      if (ns >= min_ms * 1e6) return ns / calls;
+    }
+  }
+
+  // one line per measurement: time per call and throughput of items per call
+  inline void report(const char* name, double ns, double items, const char* item)
+  {
+    printf("%-40s %12.1f ns %12.1f %s/ms\n", name, ns, items * 1e6 / ns, item);
+  }
+}
@@ -0,0 +1,47 @@
+#include "bench.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+// composite() of 1, 2 and 4 full length layers over 300 LEDs, every blend mode,
+// and a reversed Strip target
+
+#define LEDS 300u
+
+static LED leds[LEDS];
+static LED sources[4][LEDS];
+
+static const char* const MODES[] = {"alpha", "add", "multiply", "screen", "max"};
+
+int main()
+{
+  for (uint8_t l = 0; l < 4; ++l)
+  {
+    for (uint16_t i = 0; i < LEDS; ++i) sources[l][i] = LED(i * (l + 3u), 255u - i, i * 7u + l);
+  }
+
+  char name[64];
+  for (uint8_t mode = BLEND_ALPHA; mode <= BLEND_MAX; ++mode)
+  {
+    for (uint8_t count = 1; count <= 4; count *= 2)
+    {
+      Layer layers[4];
+      for (uint8_t l = 0; l < count; ++l) layers[l] = Layer(sources[l], LEDS, 0u, (BlendMode)mode, 160u);
+      double ns = bench::measure([&] {
+        composite(leds, LEDS, layers, count);
+        bench::keep(leds);
+      });
+      snprintf(name, sizeof(name), "composite %s, %u layers", MODES[mode], count);
+      bench::report(name, ns, (double)LEDS * count, "layer*px");
+    }
+  }
+
+  Strip strip(leds, LEDS, 2, true);
+  Layer layers[2] = {Layer(sources[0], LEDS), Layer(sources[1], LEDS, 0u, BLEND_ADD, 128u)};
+  double ns = bench::measure([&] {
+    strip.composite(layers, 2);
+    bench::keep(leds);
+  });
+  bench::report("Strip::composite reversed, 2 layers", ns, LEDS * 2.0, "layer*px");
+  return 0;
+}
@@ -0,0 +1,46 @@
+#include "bench.hpp"
+#include "ws2812b.hpp"
+#include "effects.hpp"
+#include "math8.hpp"
+
+using namespace WS2812B;
+
+// render() of every effect on 300 LEDs, 10000 frames per call of the timed function
+
+#define LEDS 300u
+#define FRAMES 10000u
+
+static LED leds[LEDS];
+static uint8_t heat[LEDS];
+
+template <typename E>
+static void run(const char* name, E& effect)
+{
+  double ns = bench::measure([&] {
+    for (uint16_t f = 0; f < FRAMES; ++f) effect.render();
+    bench::keep(leds);
+  }, 500u);
+  bench::report(name, ns / FRAMES, 1.0, "frames");
+}
+
+int main()
+{
+  Strip strip(leds, LEDS, 2);
+  random16Seed(1u);
+
+  Fire fire(heat, &strip);
+  run("Fire", fire);
+  Twinkle twinkle(&strip, Color(255u, 200u, 120u));
+  run("Twinkle", twinkle);
+  Comet comet(&strip, Color(40u, 120u, 255u));
+  run("Comet", comet);
+  comet.sparkle = true;
+  run("Comet, sparkle", comet);
+  TheaterChase chase(&strip, Color(255u, 0u, 0u));
+  run("TheaterChase", chase);
+  Breathing breathing(&strip, Color(0u, 255u, 80u));
+  run("Breathing", breathing);
+  Noise noise(&strip, PALETTE_OCEAN);
+  run("Noise", noise);
+  return 0;
+}
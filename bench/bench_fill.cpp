@@ -0,0 +1,43 @@
+#include "bench.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+// fill kernel against a per-pixel loop for 60, 300 and 1000 LEDs
+
+static LED leds[1000];
+
+static void run(uint16_t len)
+{
+  Strip strip(leds, len, 2);
+  char name[64];
+
+  double ns = bench::measure([&] {
+    for (uint16_t i = 0; i < len; ++i) strip.setPixelColor(i, 0x102030ul);
+    bench::keep(leds);
+  });
+  snprintf(name, sizeof(name), "setPixelColor loop, %u px", len);
+  bench::report(name, ns, len, "px");
+
+  ns = bench::measure([&] {
+    strip.fill(0x102030ul);
+    bench::keep(leds);
+  });
+  snprintf(name, sizeof(name), "Strip::fill, %u px", len);
+  bench::report(name, ns, len, "px");
+
+  ns = bench::measure([&] {
+    strip.fillFromTo(0x405060ul, 1u, len - 2u);
+    bench::keep(leds);
+  });
+  snprintf(name, sizeof(name), "Strip::fillFromTo, %u px", len - 2u);
+  bench::report(name, ns, len - 2u, "px");
+}
+
+int main()
+{
+  run(60);
+  run(300);
+  run(1000);
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include "bench.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+// pixel access of a StripGroup: linear walk over the strips (no offset table) vs the
+// binary search in the offset table, 600 LEDs split into 1, 8 and 32 strips
+
+#define LEDS 600u
+
+static LED leds[LEDS];
+
+template <uint16_t N>
+static void run()
+{
+  static Strip strips[N];
+  for (uint16_t s = 0; s < N; ++s) strips[s] = Strip(leds + s * (LEDS / N), LEDS / N, 2);
+  StripGroup walk(strips, N);
+  IndexedStripGroup<N> indexed(strips);
+
+  char name[64];
+  double ns = bench::measure([&] {
+    for (uint32_t i = 0; i < LEDS; ++i) walk.setPixelColor(i, i);
+    bench::keep(leds);
+  });
+  snprintf(name, sizeof(name), "setPixelColor, %u strips, walk", N);
+  bench::report(name, ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    for (uint32_t i = 0; i < LEDS; ++i) indexed.setPixelColor(i, i);
+    bench::keep(leds);
+  });
+  snprintf(name, sizeof(name), "setPixelColor, %u strips, offset table", N);
+  bench::report(name, ns, LEDS, "px");
+
+  uint32_t sum = 0;
+  ns = bench::measure([&] {
+    for (uint32_t i = 0; i < LEDS; ++i) sum += walk.getStripByLED((i * 337u) % LEDS);
+    bench::keep(&sum);
+  });
+  snprintf(name, sizeof(name), "getStripByLED, %u strips, walk", N);
+  bench::report(name, ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    for (uint32_t i = 0; i < LEDS; ++i) sum += indexed.getStripByLED((i * 337u) % LEDS);
+    bench::keep(&sum);
+  });
+  snprintf(name, sizeof(name), "getStripByLED, %u strips, offset table", N);
+  bench::report(name, ns, LEDS, "px");
+}
+
+int main()
+{
+  run<1>();
+  run<8>();
+  run<32>();
+  return 0;
+}
@@ -0,0 +1,57 @@
+#include "bench.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+// LED16 to LED conversion: convert() with and without gamma against a per-pixel
+// setPixelColor() of the high bytes, and the HDRBuffer render and accumulate paths
+
+#define LEDS 300u
+
+static LED leds[LEDS];
+static LED16 pixels[LEDS];
+
+int main()
+{
+  for (uint16_t i = 0; i < LEDS; ++i) pixels[i] = LED16(i * 211u, i * 97u, 65535u - i * 53u);
+  Strip strip(leds, LEDS, 2);
+
+  double ns = bench::measure([&] {
+    for (uint16_t i = 0; i < LEDS; ++i) strip.setPixelColor(i, pixels[i].r >> 8, pixels[i].g >> 8, pixels[i].b >> 8);
+    bench::keep(leds);
+  });
+  bench::report("setPixelColor, high bytes", ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    convert(leds, pixels, LEDS, 200u, false);
+    bench::keep(leds);
+  });
+  bench::report("convert", ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    convert(leds, pixels, LEDS, 200u, true);
+    bench::keep(leds);
+  });
+  bench::report("convert, gamma", ns, LEDS, "px");
+
+  HDRBuffer hdr(pixels, &strip);
+  ns = bench::measure([&] {
+    hdr.render();
+    bench::keep(leds);
+  });
+  bench::report("HDRBuffer::render", ns, LEDS, "px");
+
+  strip.setReverse(true);
+  ns = bench::measure([&] {
+    hdr.render();
+    bench::keep(leds);
+  });
+  bench::report("HDRBuffer::render, reversed", ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    for (uint16_t i = 0; i < LEDS; ++i) hdr.addPixelColor(i, LED16(3u, 5u, 7u));
+    bench::keep(pixels);
+  });
+  bench::report("HDRBuffer::addPixelColor", ns, LEDS, "px");
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include "bench.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+// 300 LED rainbow: hsv() for every LED against fillRainbow() and the HSVStepper,
+// and the gradient fills
+
+#define LEDS 300u
+
+static LED leds[LEDS];
+
+int main()
+{
+  const int16_t step = 65535 / LEDS;
+
+  double ns = bench::measure([&] {
+    for (uint16_t i = 0; i < LEDS; ++i) leds[i] = hsv(1000u + i * step, 240u, 200u);
+    bench::keep(leds);
+  });
+  bench::report("hsv() per LED", ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    fillRainbow(leds, LEDS, 1000u, step, 240u, 200u);
+    bench::keep(leds);
+  });
+  bench::report("fillRainbow", ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    HSVStepper stepper(1000u, step, 240u, 200u);
+    for (uint16_t i = 0; i < LEDS; ++i) leds[i] = stepper.next();
+    bench::keep(leds);
+  });
+  bench::report("HSVStepper::next", ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    fillGradientHSV(leds, LEDS, 0u, 40000u, 240u, 200u);
+    bench::keep(leds);
+  });
+  bench::report("fillGradientHSV", ns, LEDS, "px");
+
+  ns = bench::measure([&] {
+    fillGradientRGB(leds, LEDS, Color(255u, 0u, 40u), Color(0u, 80u, 255u));
+    bench::keep(leds);
+  });
+  bench::report("fillGradientRGB", ns, LEDS, "px");
+  return 0;
+}
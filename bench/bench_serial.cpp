@@ -0,0 +1,94 @@
+#include "bench.hpp"
+#include "ws2812b.hpp"
+#include "serial_frame.hpp"
+
+using namespace WS2812B;
+
+// serial frames of 300 LEDs for four kinds of content: average encoded size, the frame
+// rate the link allows at 115200 and 1000000 baud (8N1), and encode / decode time
+
+#define PIN 9
+#define LEDS 300u
+#define FRAMES 64u
+
+static LED frames[FRAMES][LEDS];
+static uint8_t stream[FRAMES * serial::maxFrameSize(LEDS)];
+static uint32_t sizes[FRAMES];
+static LED leds[LEDS];
+
+static void render(uint8_t scene, uint16_t f, LED* out)
+{
+  static uint32_t seed = 1u;
+  switch (scene)
+  {
+  case 0: // rainbow scroll
+    fillRainbow(out, LEDS, f * 512u, 65535 / LEDS);
+    break;
+  case 1: // comet, 8 LED tail
+    clear(out, LEDS);
+    for (uint8_t t = 0; t < 8; ++t) out[(f + LEDS - t) % LEDS] = LED(255u >> t, 160u >> t, 40u >> t);
+    break;
+  case 2: // twinkle, 3% of the LEDs change every frame
+    if (f) for (uint16_t i = 0; i < LEDS; ++i) out[i] = frames[f - 1][i];
+    else clear(out, LEDS);
+    for (uint16_t i = 0; i < LEDS * 3u / 100u; ++i)
+    {
+      seed = seed * 1103515245u + 12345u;
+      out[(seed >> 16) % LEDS] = LED(seed >> 8, seed >> 16, seed >> 24);
+    }
+    break;
+  default: // solid fade
+    fill(out, LEDS, Color(f * 4u, f * 2u, 255u - f * 4u));
+    break;
+  }
+}
+
+int main()
+{
+  static const char* const SCENES[] = {"rainbow scroll", "comet", "twinkle 3%", "solid fade"};
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  char name[64];
+
+  for (uint8_t scene = 0; scene < 4; ++scene)
+  {
+    for (uint16_t f = 0; f < FRAMES; ++f) render(scene, f, frames[f]);
+
+    uint32_t total = 0;
+    for (uint16_t f = 0; f < FRAMES; ++f)
+    {
+      sizes[f] = serial::encode(f ? frames[f - 1] : nullptr, frames[f], LEDS, stream + total);
+      total += sizes[f];
+    }
+    double avg = (double)total / FRAMES;
+    printf("%-16s %7.1f B/frame %8.1f fps @115200 %8.1f fps @1M\n", SCENES[scene], avg, 11520.0 / avg, 100000.0 / avg);
+
+    uint8_t out[serial::maxFrameSize(LEDS)];
+    double ns = bench::measure([&] {
+      for (uint16_t f = 1; f < FRAMES; ++f) bench::keep(out + serial::encode(frames[f - 1], frames[f], LEDS, out));
+    });
+    snprintf(name, sizeof(name), "encode, %s", SCENES[scene]);
+    bench::report(name, ns / (FRAMES - 1), 1.0, "frames");
+
+    SerialReceiver receiver(&strip);
+    ns = bench::measure([&] {
+      receiver.feed(stream, total > 0xFFFFu ? 0xFFFFu : (uint16_t)total);
+      for (uint32_t done = 0xFFFFu; done < total; done += 0xFFFFu)
+      {
+        uint32_t left = total - done;
+        receiver.feed(stream + done, left > 0xFFFFu ? 0xFFFFu : (uint16_t)left);
+      }
+      host::clearEdges(PIN);
+    });
+    snprintf(name, sizeof(name), "decode + show, %s", SCENES[scene]);
+    bench::report(name, ns / FRAMES, 1.0, "frames");
+  }
+
+  // show() alone, to tell the decoder from the host transmit recording
+  double ns = bench::measure([&] {
+    strip.show();
+    host::clearEdges(PIN);
+  });
+  bench::report("Strip::show alone", ns, 1.0, "frames");
+  return 0;
+}
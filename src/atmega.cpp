@@ -1,132 +1,246 @@
 #ifdef AVR
 #include "ws2812b.hpp"
-
-#if F_CPU == 16000000L
-
-
-static uint32_t endTime = 0u;
+#include "timing.hpp"
+
+#ifndef F_CPU
+#error "F_CPU is not defined."
+#endif
+
+/**
+ * Pętla bitu (cykle między zapisami do portu bez opóźnień):
+ *   st hi   -> st next : 2 (st)
+ *   st next -> st lo   : 2 (st)
+ *   st lo   -> st hi   : 9 (st, lsl, mov, sbrc + mov, dec, brne)
+ *   między bajtami     : +14 (sbiw, breq, ld, mul, mov, clr, mov, sbrc + mov, ldi, rjmp - brne), +10 bez skalowania
+ * Opóźnienia d1, d2, d3 (nop) są liczone w czasie kompilacji z F_CPU.
+ */
+using SerialLoop = WS2812B::timing::SerialLoop<F_CPU>;
+using SerialRawLoop = WS2812B::timing::SerialRawLoop<F_CPU>;
+
+/**
+ * Pętla równoległa (po przygotowanym buforze, bez przerw między bajtami):
+ *   st hi   -> st data : 2 (st)
+ *   st data -> st lo   : 2 (st)
+ *   st lo   -> st hi   : 9 (st, ld, or, sbiw, brne)
+ */
+using ParallelLoop = WS2812B::timing::ParallelLoop<F_CPU>;
+
+static_assert(SerialLoop::t0h_ok, "WS2812B: T0H can't be kept in 250-550 ns at this F_CPU");
+static_assert(SerialLoop::t1h_ok, "WS2812B: T1H can't be kept in 650-950 ns at this F_CPU");
+static_assert(SerialLoop::t0l_ok, "WS2812B: T0L can't be kept in 700-5000 ns at this F_CPU");
+static_assert(SerialLoop::t1l_ok, "WS2812B: T1L can't be kept in 300-5000 ns at this F_CPU");
+static_assert(SerialLoop::gap_ok && SerialRawLoop::gap_ok, "WS2812B: low phase between bytes exceeds 5000 ns at this F_CPU");
+static_assert(ParallelLoop::ok, "WS2812B: parallel output can't meet WS2812B timing at this F_CPU");
+
+
+static void (*show_done_callback)(uint8_t pin) = nullptr;
 
 namespace WS2812B
 {
 
-  void _extern_timer_show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright, uint32_t& timer)
+  // Skalowanie składowej koloru wg jasności
+#define WS2812B_AVR_SCALE \
+      "mul  %[byte], %[bright]"       "\n\t" \
+      "mov  %[byte], r1"              "\n\t" \
+      "clr  r1"                       "\n\t"
+
+#define WS2812B_AVR_NO_SCALE
+
+#define WS2812B_AVR_DELAY(N) \
+      ".rept " N                      "\n\t" \
+      "nop"                           "\n\t" \
+      ".endr"                         "\n\t"
+
+#define WS2812B_AVR_LOOP(SCALE) \
+      "1:"                            "\n\t" /* Start bitu */ \
+      "st   %a[port], %[hi]"          "\n\t" /* Ustawienie pinu na high */ \
+      WS2812B_AVR_DELAY("%[d1]") \
+      "st   %a[port], %[next]"        "\n\t" /* Wyślij bit (dla 0 pin przechodzi na low, t0h) */ \
+      WS2812B_AVR_DELAY("%[d2]") \
+      "st   %a[port], %[lo]"          "\n\t" /* Ustawienie pinu na low (t1h) */ \
+      "lsl  %[byte]"                  "\n\t" /* Przesunięcie kolejnego bitu */ \
+      "mov  %[next], %[lo]"           "\n\t" /* Przygotowanie stanu dla kolejnego bitu */ \
+      "sbrc %[byte], 7"               "\n\t" \
+      "mov  %[next], %[hi]"           "\n\t" \
+      "dec  %[bit]"                   "\n\t" /* Zmniejszenie licznika bitów */ \
+      WS2812B_AVR_DELAY("%[d3]") \
+      "brne 1b"                       "\n\t" /* Kolejny bit (t0l / t1l) */ \
+      "sbiw %[count], 1"              "\n\t" /* Zmniejsz licznik składowych */ \
+      "breq 2f"                       "\n\t" \
+      "ld   %[byte], %a[ptr]+"        "\n\t" /* Załaduj następną składową koloru (w stanie niskim) */ \
+      SCALE \
+      "mov  %[next], %[lo]"           "\n\t" \
+      "sbrc %[byte], 7"               "\n\t" \
+      "mov  %[next], %[hi]"           "\n\t" \
+      "ldi  %[bit], 8"                "\n\t" /* Licznik bitów dla następnej składowej */ \
+      "rjmp 1b"                       "\n\t" \
+      "2:"                            "\n"
+
+  static void sendBytes(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint8_t bright, bool scale, uint32_t& timer)
   {
-    if (leds == nullptr) return;
+    if (bytes == nullptr || num_bytes == 0) return;
 
     volatile uint8_t* port = portOutputRegister(digitalPinToPort(pin));
     uint8_t pinMask = digitalPinToBitMask(pin);
-    volatile uint16_t i = len * 3;
-    volatile uint8_t *ptr = (volatile uint8_t*)leds;
-    volatile uint8_t b = *ptr++;
-    volatile uint8_t hi = *port | pinMask; // Ustawienie stanu wysokiego pinu
-    volatile uint8_t lo = *port & ~pinMask; // Ustawienie stanu niskiego pinu
-    volatile uint8_t next = lo, bit = 8;    // Inicjalizacja zmiennych
-
+    uint16_t i = num_bytes;
+    const uint8_t* ptr = bytes;
+    uint8_t b = *ptr++;
+    if (scale) b = (b * bright) >> 8;
+    uint8_t bit = 8;
 
     while (micros() - timer < 50ul) {}  // Czekanie na możliwość transmisji
     noInterrupts();  // Wyłączenie przerwań, aby transmisja była dokładna
 
-    /**
-     * t0h = 250ns - 550ns    | 5   -   8   clock ticks
-     * t1h = 650ns - 950ns    | 11  -   15  clock ticks
-     * t0l = 700ns - 1000ns   | 12  -   16  clock ticks
-     * t1l = 300ns - 600ns    | 5   -   9   clock ticks
-     */
-
-    asm volatile(
-      "first_byte_map:"               // Przeskalowanie jasności dla pierwszej składowej barwy
-      "\n\t"
-      "\n\t"
-      "mul %[byte], %[bright]"        // Skalowanie składowej koloru wg jasności
-      "\n\t"
-      "mov %[byte], r1"               // Zapisz wynik do rejestru
-      "\n\t"
-      "clr r1"                        // Wyczyszczenie rejestru r1
-      "\n\t"
-      "ws2812b_transmission:"         // Start transmisji
-      "\n\t"
-      "st   %a[port], %[hi]"          // Ustawienie pinu na high (wysokie napięcie) - 125 ns
-      "\n\t"
-      "sbrc %[byte], 7"               // Sprawdzenie najstarszego bitu składowej koloru - 62.5/125 ns
-      "\n\t"
-      "mov  %[next], %[hi]"           // Jeśli bit to 1, przygotuj wysoki stan - 62.5 ns
-      "\n\t"
-      "dec  %[bit]"                   // Zmniejszenie licznika bitów - 62.5 ns
-      "\n\t"
-      "st   %a[port], %[next]"        // Wyślij bit - 125 ns
-      "\n\t"
-      "mov  %[next], %[lo]"           // Przygotowanie do kolejnego bitu (stan niski) - 62.5 ns
-      "\n\t"
-      "breq nextbyte"                 // Sprawdzenie, czy wszystkie bity zostały wysłane - 62.5/125 ns
-      "\n\t"
-      "rol  %[byte]"                  // Przesunięcie kolejnego bitu - 62.5 ns
-      "\n\t"
-      "rjmp .+0"                           // 125  ns <-dddddddddddddddd
-      "\n\t"
-      "nop"                           // 62.5 ns
-      "\n\t"
-      "nop"                           // 62.5 ns
-      "\n\t"
-      "nop"                           // 62.5 ns
-      "\n\t"
-      "st   %a[port], %[lo]"          // Ustawienie pinu na low (niskie napięcie) - 125 ns
-      "\n\t"
-      "rjmp .+0"                           // Dodatkowe opóźnienie - 125 ns <-dddddddddddddddddddddd
-      "\n\t"
-      "rjmp ws2812b_transmission"     // Powrót do początku pętli - 125 ns
-      "\n\t"
-      "nextbyte:"
-      "\n\t"
-      "ldi  %[bit], 8"                // Inicjalizacja licznika bitów dla następnej składowej - 62.5 ns
-      "\n\t"
-      "ld   %[byte], %a[ptr]+"        // Załaduj następną składową koloru - 125 ns
-      "\n\t"
-      "mul %[byte], %[bright]"        // Przeskalowanie składowej koloru wg jasności - 125 ns
-      "\n\t"
-      "mov %[byte], r1"               // Zapisz wynik do rejestru - 125 ns
-      "\n\t"
-      "clr r1"                        // Wyczyszczenie rejestru r1 - 125 ns
-      "\n\t"
-      "st   %a[port], %[lo]"          // Ustawienie pinu na low (niskie napięcie) - 125 ns
-      "\n\t"
-      "nop"                           // 62.5 ns
-      "\n\t"
-      "nop"                           // 62.5 ns
-      "\n\t"
-      "sbiw %[count], 1"              // Zmniejsz licznik składowych - 125 ns
-      "\n\t"
-      "brne ws2812b_transmission"     // Powrót do początku pętli, jeśli są jeszcze dane - 62.5/125 ns
-      "\n"
-      : [port] "+e" (port), [byte] "+r" (b), [bit] "+r" (bit), [next] "+r" (next), [count] "+w" (i)
-      : [ptr] "e" (ptr), [hi] "r" (hi), [lo] "r" (lo), [bright] "r" (bright)
-    );
+    uint8_t hi = *port | pinMask; // Ustawienie stanu wysokiego pinu
+    uint8_t lo = *port & ~pinMask; // Ustawienie stanu niskiego pinu
+    uint8_t next = (b & 0x80) ? hi : lo;
+
+    if (scale)
+    {
+      asm volatile(
+        WS2812B_AVR_LOOP(WS2812B_AVR_SCALE)
+        : [port] "+e" (port), [byte] "+r" (b), [bit] "+d" (bit), [next] "+r" (next), [count] "+w" (i), [ptr] "+e" (ptr)
+        : [hi] "r" (hi), [lo] "r" (lo), [bright] "r" (bright),
+          [d1] "n" (SerialLoop::d1), [d2] "n" (SerialLoop::d2), [d3] "n" (SerialLoop::d3)
+      );
+    }
+    else
+    {
+      asm volatile(
+        WS2812B_AVR_LOOP(WS2812B_AVR_NO_SCALE)
+        : [port] "+e" (port), [byte] "+r" (b), [bit] "+d" (bit), [next] "+r" (next), [count] "+w" (i), [ptr] "+e" (ptr)
+        : [hi] "r" (hi), [lo] "r" (lo),
+          [d1] "n" (SerialLoop::d1), [d2] "n" (SerialLoop::d2), [d3] "n" (SerialLoop::d3)
+      );
+    }
 
     interrupts();  // Włącz przerwania
     timer = micros();  // Zapisz czas zakończenia transmisji
+    if (show_done_callback) show_done_callback(pin);
+  }
+
+  void _extern_timer_show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright, uint32_t& timer)
+  {
+    sendBytes((const uint8_t*)leds, len * 3, pin, bright, true, timer);
+  }
+
+  void _extern_timer_show_raw(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint32_t& timer)
+  {
+    sendBytes(bytes, num_bytes, pin, 255u, false, timer);
+  }
+
+  void _extern_timer_show_bytes(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint8_t bright, uint32_t& timer)
+  {
+    sendBytes(bytes, num_bytes, pin, bright, true, timer);
+  }
+
+  // transmisja jest synchroniczna, zostaje tylko czas zatrzaśnięcia
+  bool _extern_can_show(uint8_t, uint32_t timer)
+  {
+    return micros() - timer >= 50ul;
   }
 
   void show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright)
   {
-    _extern_timer_show(leds, len, pin, bright, endTime);
+    _extern_timer_show(leds, len, pin, bright, pinTimer(pin));
   }
-}
 
+  // transmisja jest synchroniczna, po powrocie z show() dane są już wysłane
+  void waitShowDone(uint8_t) {}
 
-#elif F_CPU == 8000000L 
+  void waitShowDone() {}
 
-namespace WS2812B
-{
-  void _extern_timer_show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright)
+  void onShowDone(void (*callback)(uint8_t pin))
   {
-    
+    show_done_callback = callback;
   }
-}
 
+  void _extern_show_done(uint8_t pin)
+  {
+    if (show_done_callback) show_done_callback(pin);
+  }
 
-#else 
+  bool _extern_begin(uint8_t)
+  {
+    return true;
+  }
 
-#error "Only 16 Mhz F_CPU now is supported, sorry."
+  uint8_t _extern_pin_port(uint8_t pin)
+  {
+    return digitalPinToPort(pin);
+  }
+
+  /**
+   * Wysyła do 8 pasków podłączonych do jednego portu jednocześnie.
+   * Bajty wszystkich pasków są najpierw skalowane i transponowane do bufora (transposeFrame),
+   * po jednej wartości portu na bit, a pętla asm wystawia je bez przerw między bajtami
+   * (skalowanie i transpozycja w stanie niskim trwałyby setki cykli, dłużej niż TL_MAX).
+   * Bez bufora lub gdy jest za mały paski są wysyłane po kolei.
+   */
+  void _extern_parallel_show(Strip* const* strips, uint8_t n, uint8_t bright, uint8_t* buffer, uint16_t size)
+  {
+    uint8_t masks[WS2812B_PARALLEL_MAX];
+    const uint8_t* ptrs[WS2812B_PARALLEL_MAX];
+    uint16_t lens[WS2812B_PARALLEL_MAX];
+    uint8_t all = 0;
+    bool collision = false;
+    for (uint8_t s = 0; s < n; ++s)
+    {
+      masks[s] = digitalPinToBitMask(strips[s]->pin);
+      if (all & masks[s] || strips[s]->leds == nullptr) collision = true;
+      all |= masks[s];
+      ptrs[s] = (const uint8_t*)strips[s]->leds;
+      lens[s] = strips[s]->count * 3;
+    }
+
+    uint16_t count = (n < 2 || collision) ? 0 : transposeFrame(ptrs, lens, masks, n, bright, buffer, size);
+    if (count == 0)
+    {
+      for (uint8_t s = 0; s < n; ++s) _extern_timer_show(strips[s]->leds, strips[s]->count, strips[s]->pin, bright, strips[s]->timer);
+      return;
+    }
+
+    volatile uint8_t* port = portOutputRegister(digitalPinToPort(strips[0]->pin));
+    for (uint8_t s = 0; s < n; ++s)
+    {
+      while (micros() - strips[s]->timer < 50ul) {}
+    }
+
+    noInterrupts();
+    uint8_t lo = *port & ~all;
+    uint8_t hi = lo | all;
+    uint8_t data;
+    const uint8_t* p = buffer;
+
+    asm volatile(
+      "ld   %[data], %a[ptr]+"        "\n\t" /* Wartość portu dla pierwszego bitu */
+      "or   %[data], %[lo]"           "\n\t"
+      "1:"                            "\n\t"
+      "st   %a[port], %[hi]"          "\n\t" /* Wszystkie piny na high */
+      WS2812B_AVR_DELAY("%[d1]")
+      "st   %a[port], %[data]"        "\n\t" /* Piny z bitem 0 na low (t0h) */
+      WS2812B_AVR_DELAY("%[d2]")
+      "st   %a[port], %[lo]"          "\n\t" /* Wszystkie piny na low (t1h) */
+      "ld   %[data], %a[ptr]+"        "\n\t" /* Wartość portu dla kolejnego bitu */
+      "or   %[data], %[lo]"           "\n\t" /* Pozostałe piny portu bez zmian */
+      "sbiw %[count], 1"              "\n\t"
+      WS2812B_AVR_DELAY("%[d3]")
+      "brne 1b"                       "\n"    /* t0l / t1l */
+      : [ptr] "+e" (p), [data] "=&r" (data), [count] "+w" (count)
+      : [port] "e" (port), [hi] "r" (hi), [lo] "r" (lo),
+        [d1] "n" (ParallelLoop::d1), [d2] "n" (ParallelLoop::d2), [d3] "n" (ParallelLoop::d3)
+      : "memory"
+    );
+
+    interrupts();
+    uint32_t t = micros();
+    for (uint8_t s = 0; s < n; ++s)
+    {
+      strips[s]->timer = t;
+      if (show_done_callback) show_done_callback(strips[s]->pin);
+    }
+  }
+}
 
-#endif // F_CPU == 16000000L
 
 #endif // AVR
@@ -0,0 +1,127 @@
+#pragma once
+#ifdef AVR
+#include "timing.hpp"
+
+/**
+ * Wysyłanie dla pinu znanego w czasie kompilacji (StaticStrip).
+ * Adres portu i maska są stałymi, więc pętla używa `out` (1 cykl) zamiast `st` (2 cykle)
+ * przez wskaźnik i nie ma narzutu digitalPinToPort/digitalPinToBitMask na ramkę.
+ *
+ *   out hi   -> out next : 1 (out)
+ *   out next -> out lo   : 1 (out)
+ *   out lo   -> out hi   : 8 (out, lsl, mov, sbrc + mov, dec, brne)
+ *   między bajtami       : +14 (sbiw, breq, ld, mul, mov, clr, mov, sbrc + mov, ldi, rjmp - brne)
+ */
+
+namespace WS2812B
+{
+  void _extern_show_done(uint8_t pin);
+
+  namespace avr
+  {
+    using StaticLoop = timing::StaticLoop<F_CPU>;
+  }
+
+  // io - adres portu w przestrzeni I/O (dla `out`)
+#define WS2812B_AVR_PIN(PIN, IO, BIT) \
+  template <> \
+  struct PinTraits<PIN> \
+  { \
+    static constexpr bool fixed = true; \
+    static constexpr uint8_t io = IO; \
+    static constexpr uint8_t mask = 1 << BIT; \
+  };
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__)
+  // PORTB = 0x05, PORTC = 0x08, PORTD = 0x0B (adresy I/O)
+  WS2812B_AVR_PIN(0, 0x0B, 0)
+  WS2812B_AVR_PIN(1, 0x0B, 1)
+  WS2812B_AVR_PIN(2, 0x0B, 2)
+  WS2812B_AVR_PIN(3, 0x0B, 3)
+  WS2812B_AVR_PIN(4, 0x0B, 4)
+  WS2812B_AVR_PIN(5, 0x0B, 5)
+  WS2812B_AVR_PIN(6, 0x0B, 6)
+  WS2812B_AVR_PIN(7, 0x0B, 7)
+  WS2812B_AVR_PIN(8, 0x05, 0)
+  WS2812B_AVR_PIN(9, 0x05, 1)
+  WS2812B_AVR_PIN(10, 0x05, 2)
+  WS2812B_AVR_PIN(11, 0x05, 3)
+  WS2812B_AVR_PIN(12, 0x05, 4)
+  WS2812B_AVR_PIN(13, 0x05, 5)
+  WS2812B_AVR_PIN(14, 0x08, 0)
+  WS2812B_AVR_PIN(15, 0x08, 1)
+  WS2812B_AVR_PIN(16, 0x08, 2)
+  WS2812B_AVR_PIN(17, 0x08, 3)
+  WS2812B_AVR_PIN(18, 0x08, 4)
+  WS2812B_AVR_PIN(19, 0x08, 5)
+#endif
+
+#undef WS2812B_AVR_PIN
+
+  template <uint8_t PIN>
+  struct StaticShow<PIN, true>
+  {
+    static_assert(avr::StaticLoop::ok, "WS2812B: static pin output can't meet WS2812B timing at this F_CPU");
+
+    static void send(const uint8_t* bytes, uint16_t num_bytes, uint8_t bright, uint32_t& timer)
+    {
+      if (bytes == nullptr || num_bytes == 0) return;
+
+      uint16_t i = num_bytes;
+      const uint8_t* ptr = bytes;
+      uint8_t b = (*ptr++ * bright) >> 8;
+      uint8_t bit = 8;
+
+      while (micros() - timer < 50ul) {}  // Czekanie na możliwość transmisji
+      noInterrupts();
+
+      uint8_t port = *(volatile uint8_t*)(PinTraits<PIN>::io + 0x20);
+      uint8_t hi = port | PinTraits<PIN>::mask;
+      uint8_t lo = port & ~PinTraits<PIN>::mask;
+      uint8_t next = (b & 0x80) ? hi : lo;
+
+      asm volatile(
+        "1:"                            "\n\t"
+        "out  %[io], %[hi]"             "\n\t" /* Ustawienie pinu na high */
+        ".rept %[d1]"                   "\n\t"
+        "nop"                           "\n\t"
+        ".endr"                         "\n\t"
+        "out  %[io], %[next]"           "\n\t" /* Wyślij bit (t0h) */
+        ".rept %[d2]"                   "\n\t"
+        "nop"                           "\n\t"
+        ".endr"                         "\n\t"
+        "out  %[io], %[lo]"             "\n\t" /* Ustawienie pinu na low (t1h) */
+        "lsl  %[byte]"                  "\n\t"
+        "mov  %[next], %[lo]"           "\n\t"
+        "sbrc %[byte], 7"               "\n\t"
+        "mov  %[next], %[hi]"           "\n\t"
+        "dec  %[bit]"                   "\n\t"
+        ".rept %[d3]"                   "\n\t"
+        "nop"                           "\n\t"
+        ".endr"                         "\n\t"
+        "brne 1b"                       "\n\t" /* Kolejny bit (t0l / t1l) */
+        "sbiw %[count], 1"              "\n\t"
+        "breq 2f"                       "\n\t"
+        "ld   %[byte], %a[ptr]+"        "\n\t" /* Następna składowa, skalowanie jasnością */
+        "mul  %[byte], %[bright]"       "\n\t"
+        "mov  %[byte], r1"              "\n\t"
+        "clr  r1"                       "\n\t"
+        "mov  %[next], %[lo]"           "\n\t"
+        "sbrc %[byte], 7"               "\n\t"
+        "mov  %[next], %[hi]"           "\n\t"
+        "ldi  %[bit], 8"                "\n\t"
+        "rjmp 1b"                       "\n\t"
+        "2:"                            "\n"
+        : [byte] "+r" (b), [bit] "+d" (bit), [next] "+r" (next), [count] "+w" (i), [ptr] "+e" (ptr)
+        : [io] "I" (PinTraits<PIN>::io), [hi] "r" (hi), [lo] "r" (lo), [bright] "r" (bright),
+          [d1] "n" (avr::StaticLoop::d1), [d2] "n" (avr::StaticLoop::d2), [d3] "n" (avr::StaticLoop::d3)
+      );
+
+      interrupts();
+      timer = micros();
+      _extern_show_done(PIN);
+    }
+  };
+}
+
+#endif // AVR
@@ -0,0 +1,304 @@
+#include "dmx.hpp"
+
+#if WS2812B_DMX_UDP
+#ifdef ESP32
+#include <lwip/sockets.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif
+#endif
+
+/**
+ * E1.31 data packet          | E1.31 sync packet     | ArtDmx              | ArtSync
+ *   4  "ASC-E1.17"           |   4  "ASC-E1.17"      |   0  "Art-Net"      |  0  "Art-Net"
+ *  18  root vector 0x04      |  18  root vector 0x08 |   8  opcode 0x5000  |  8  opcode 0x5200
+ *  40  framing vector 0x02   |  40  vector 0x01      |  12  sequence       |
+ * 109  sync address          |  44  sequence         |  14  port address   |
+ * 111  sequence              |  45  sync address     |  16  length         |
+ * 112  options               |                       |  18  slots          |
+ * 113  universe              |                       |                     |
+ * 123  slot count + 1        |                       |                     |
+ * 125  start code, slots     |                       |                     |
+ */
+#define WS2812B_E131_ROOT_DATA 0x04ul
+#define WS2812B_E131_ROOT_EXTENDED 0x08ul
+#define WS2812B_E131_FRAMING_DATA 0x02ul
+#define WS2812B_E131_FRAMING_SYNC 0x01ul
+#define WS2812B_E131_OPTION_SKIP 0xC0 // preview data, stream terminated
+#define WS2812B_ARTNET_DMX 0x5000
+#define WS2812B_ARTNET_SYNC 0x5200
+#define WS2812B_ARTSYNC_TIMEOUT 4000ul
+
+namespace WS2812B
+{
+  static const uint8_t E131_ID[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+  static const uint8_t ARTNET_ID[8] = {'A', 'r', 't', '-', 'N', 'e', 't', 0};
+
+  static uint16_t be16(const uint8_t* p)
+  {
+    return (uint16_t)(p[0] << 8 | p[1]);
+  }
+
+  static uint32_t be32(const uint8_t* p)
+  {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+  }
+
+  DMXReceiver::DMXReceiver(StripGroup* group, DMXUniverse* universes, uint8_t len)
+  : group{group},
+    universes{universes},
+    len{len > WS2812B_DMX_UNIVERSES_MAX ? (uint8_t)WS2812B_DMX_UNIVERSES_MAX : len},
+    all{0u},
+    received{0u},
+    seen{0u},
+    sync_address{0u},
+    artsync_ms{0u},
+    artsync{false},
+    frame_start{0u},
+    packets{0u},
+    dropped{0u},
+    frames{0u},
+    last_latency{0u},
+    max_latency{0u},
+    second_start{0u},
+    second_packets{0u},
+    pps{0u}
+#if WS2812B_DMX_UDP
+    , sock{-1}
+#endif
+  {
+    for (uint8_t i = 0; i < this->len; ++i) all |= 1ul << i;
+  }
+
+  bool DMXReceiver::handle(const uint8_t* packet, uint16_t len)
+  {
+    if (packet == nullptr || group == nullptr || universes == nullptr) return false;
+    bool used = handleArtNet(packet, len) || handleE131(packet, len);
+    if (!used) return false;
+
+    uint32_t now = millis();
+    if (now - second_start >= 1000ul)
+    {
+      pps = now - second_start < 2000ul ? second_packets : 0u;
+      second_packets = 0u;
+      second_start = now;
+    }
+    ++second_packets;
+    ++packets;
+    return true;
+  }
+
+  bool DMXReceiver::handleE131(const uint8_t* p, uint16_t len)
+  {
+    if (len < 49 || memcmp(p + 4, E131_ID, sizeof(E131_ID)) != 0) return false;
+
+    uint32_t root = be32(p + 18);
+    if (root == WS2812B_E131_ROOT_EXTENDED)
+    {
+      if (be32(p + 40) != WS2812B_E131_FRAMING_SYNC) return false;
+      if (sync_address == 0u || be16(p + 45) != sync_address) return false;
+      sync();
+      return true;
+    }
+
+    if (root != WS2812B_E131_ROOT_DATA || len < 126 || be32(p + 40) != WS2812B_E131_FRAMING_DATA) return false;
+    if (p[117] != 0x02 || p[118] != 0xA1 || p[125] != 0u) return false; // set property, start code 0
+    if (p[112] & WS2812B_E131_OPTION_SKIP) return false;
+
+    uint16_t count = be16(p + 123);
+    if (count == 0u) return false;
+    --count;
+    if (count > len - 126) count = len - 126;
+
+    uint16_t address = be16(p + 109);
+    if (!data(be16(p + 113), p[111], p + 126, count, address != 0u)) return false;
+    sync_address = address;
+    return true;
+  }
+
+  bool DMXReceiver::handleArtNet(const uint8_t* p, uint16_t len)
+  {
+    if (len < 10 || memcmp(p, ARTNET_ID, sizeof(ARTNET_ID)) != 0) return false;
+
+    uint16_t opcode = p[8] | p[9] << 8;
+    if (opcode == WS2812B_ARTNET_SYNC)
+    {
+      artsync = true;
+      artsync_ms = millis();
+      sync();
+      return true;
+    }
+    if (opcode != WS2812B_ARTNET_DMX || len < 18) return false;
+
+    uint16_t count = be16(p + 16);
+    if (count > len - 18) count = len - 18;
+    if (artsync && millis() - artsync_ms > WS2812B_ARTSYNC_TIMEOUT) artsync = false;
+
+    // sequence 0 - the source doesn't number its packets
+    uint16_t universe = p[14] | (p[15] & 0x7F) << 8;
+    return data(universe, p[12] ? p[12] : -1, p + 18, count, artsync);
+  }
+
+  // sequence -1 - not checked, hold - the frame is shown by a sync packet
+  bool DMXReceiver::data(uint16_t universe, int16_t sequence, const uint8_t* slots, uint16_t count, bool hold)
+  {
+    bool used = false;
+    for (uint8_t i = 0; i < len; ++i)
+    {
+      DMXUniverse& u = universes[i];
+      if (u.universe != universe) continue;
+      uint32_t bit = 1ul << i;
+
+      if (sequence >= 0 && (seen & bit))
+      {
+        int8_t diff = (int8_t)((uint8_t)sequence - u.sequence);
+        if (diff <= 0 && diff > -20)
+        {
+          ++dropped;
+          return used;
+        }
+      }
+      if (sequence >= 0)
+      {
+        u.sequence = (uint8_t)sequence;
+        seen |= bit;
+      }
+
+      // the universe repeats before the frame completed, show what arrived
+      if (received & bit) frame();
+      if (received == 0u) frame_start = micros();
+      write(u, slots, count);
+      received |= bit;
+      used = true;
+    }
+    if (used && !hold && received == all) frame();
+    return used;
+  }
+
+  void DMXReceiver::sync()
+  {
+    if (received) frame();
+  }
+
+  void DMXReceiver::write(const DMXUniverse& u, const uint8_t* slots, uint16_t count)
+  {
+    if (u.channel >= count) return;
+    uint16_t pixels = (count - u.channel) / (u.order >= GRBW ? 4u : 3u);
+    if (pixels > u.count) pixels = u.count;
+    group->writePixelsRGB(u.first, slots + u.channel, pixels, u.order);
+  }
+
+  void DMXReceiver::frame()
+  {
+    group->show();
+    received = 0u;
+    ++frames;
+    last_latency = micros() - frame_start;
+    if (last_latency > max_latency) max_latency = last_latency;
+  }
+
+  uint32_t DMXReceiver::packetsReceived() const
+  {
+    return packets;
+  }
+
+  uint32_t DMXReceiver::packetsDropped() const
+  {
+    return dropped;
+  }
+
+  uint16_t DMXReceiver::packetsPerSecond() const
+  {
+    return pps;
+  }
+
+  uint32_t DMXReceiver::framesShown() const
+  {
+    return frames;
+  }
+
+  uint32_t DMXReceiver::latency() const
+  {
+    return last_latency;
+  }
+
+  uint32_t DMXReceiver::maxLatency() const
+  {
+    return max_latency;
+  }
+
+  void DMXReceiver::resetStats()
+  {
+    packets = 0u;
+    dropped = 0u;
+    frames = 0u;
+    last_latency = 0u;
+    max_latency = 0u;
+    second_packets = 0u;
+    pps = 0u;
+  }
+
+#if WS2812B_DMX_UDP
+  DMXReceiver::~DMXReceiver()
+  {
+    end();
+  }
+
+  bool DMXReceiver::begin(DMXProtocol protocol, uint16_t port)
+  {
+    end();
+    if (port == 0u) port = protocol == DMX_E131 ? WS2812B_E131_PORT : WS2812B_ARTNET_PORT;
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) return false;
+    int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+      end();
+      return false;
+    }
+
+    // 239.255.<universe high>.<universe low>, unicast still works when joining fails
+    if (protocol == DMX_E131)
+    {
+      for (uint8_t i = 0; i < len; ++i)
+      {
+        ip_mreq group_addr;
+        memset(&group_addr, 0, sizeof(group_addr));
+        group_addr.imr_multiaddr.s_addr = htonl(0xEFFF0000ul | universes[i].universe);
+        group_addr.imr_interface.s_addr = htonl(INADDR_ANY);
+        setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group_addr, sizeof(group_addr));
+      }
+    }
+    return true;
+  }
+
+  void DMXReceiver::end()
+  {
+    if (sock < 0) return;
+    close(sock);
+    sock = -1;
+  }
+
+  uint16_t DMXReceiver::poll()
+  {
+    if (sock < 0) return 0u;
+    uint16_t handled = 0u;
+    int n;
+    while ((n = recvfrom(sock, packet, sizeof(packet), MSG_DONTWAIT, nullptr, nullptr)) > 0)
+    {
+      if (handle(packet, (uint16_t)n)) ++handled;
+    }
+    return handled;
+  }
+#endif
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "ws2812b.hpp"
+
+/**
+ * E1.31 (sACN) and Art-Net DMX receiver.
+ *
+ * Every mapped universe feeds a range of LEDs of a StripGroup; slots are decoded from the
+ * packet straight into the strip buffers, there is no intermediate frame. The group is shown
+ * when every mapped universe of the frame arrived, or on the sync packet when the source
+ * synchronizes its universes (E1.31 sync address, Art-Net ArtSync).
+ *
+ * handle() parses one UDP payload and works with any transport. On ESP32 and host builds
+ * begin() / poll() read the packets from a non blocking UDP socket.
+ */
+
+#if defined(ESP32) || defined(WS2812B_HOST)
+#define WS2812B_DMX_UDP 1
+#else
+#define WS2812B_DMX_UDP 0
+#endif
+
+#define WS2812B_E131_PORT 5568
+#define WS2812B_ARTNET_PORT 6454
+#define WS2812B_DMX_UNIVERSES_MAX 32
+// E1.31 header (126 bytes) + 512 slots, Art-Net needs 18 + 512
+#define WS2812B_DMX_PACKET_SIZE 638
+
+namespace WS2812B
+{
+  enum DMXProtocol : uint8_t
+  {
+    DMX_E131,
+    DMX_ARTNET
+  };
+
+  struct DMXUniverse
+  {
+    uint16_t universe; // E1.31 universe 1 - 63999, Art-Net 15 bit port address
+    uint16_t channel; // slot of the first pixel, 0 based
+    uint32_t first; // first LED in the group
+    uint16_t count; // number of LEDs, a pixel can't span two universes
+    ColorOrder order; // channel order of a pixel in the universe, the W channel is added to r, g and b
+    uint8_t sequence; // last accepted sequence number, kept by the receiver
+  };
+
+  class DMXReceiver
+  {
+  public:
+    DMXReceiver(StripGroup* group, DMXUniverse* universes, uint8_t len);
+#if WS2812B_DMX_UDP
+    ~DMXReceiver();
+    // port 0 - default port of the protocol, E1.31 joins the multicast group of every universe
+    bool begin(DMXProtocol protocol, uint16_t port = 0u);
+    void end();
+    // handles all pending packets, returns their number
+    uint16_t poll();
+#endif
+    // one UDP payload of either protocol, false if it was not used
+    bool handle(const uint8_t* packet, uint16_t len);
+    uint32_t packetsReceived() const;
+    uint32_t packetsDropped() const; // out of sequence
+    uint16_t packetsPerSecond() const;
+    uint32_t framesShown() const;
+    uint32_t latency() const; // us from the first packet of the last frame until its show() returned
+    uint32_t maxLatency() const;
+    void resetStats();
+
+  private:
+    bool handleE131(const uint8_t* packet, uint16_t len);
+    bool handleArtNet(const uint8_t* packet, uint16_t len);
+    bool data(uint16_t universe, int16_t sequence, const uint8_t* slots, uint16_t count, bool hold);
+    void sync();
+    void write(const DMXUniverse& u, const uint8_t* slots, uint16_t count);
+    void frame();
+    StripGroup* group;
+    DMXUniverse* universes;
+    uint8_t len;
+    uint32_t all; // bit of every mapped universe
+    uint32_t received; // universes of the current frame
+    uint32_t seen; // universes with a valid sequence number
+    uint16_t sync_address; // E1.31 sync universe of the current frame, 0 - none
+    uint32_t artsync_ms; // last ArtSync, Art-Net waits for sync up to 4 s after it
+    bool artsync;
+    uint32_t frame_start;
+    uint32_t packets;
+    uint32_t dropped;
+    uint32_t frames;
+    uint32_t last_latency;
+    uint32_t max_latency;
+    uint32_t second_start;
+    uint16_t second_packets;
+    uint16_t pps;
+#if WS2812B_DMX_UDP
+    int sock;
+    uint8_t packet[WS2812B_DMX_PACKET_SIZE];
+#endif
+  };
+}
@@ -0,0 +1,215 @@
+#include "effects.hpp"
+#include "math8.hpp"
+
+namespace WS2812B
+{
+  // value of every noise lattice point, a permutation of 0 - 255
+  static const uint8_t __NOISE_PERM[256] PROGMEM = {
+    97, 214, 102, 6, 39, 41, 58, 211, 160, 36, 252, 194, 68, 0, 210, 131,
+    165, 154, 32, 195, 140, 70, 254, 177, 155, 91, 158, 238, 224, 115, 244, 144,
+    33, 12, 229, 101, 56, 9, 128, 66, 223, 95, 145, 73, 54, 27, 230, 186,
+    231, 183, 170, 28, 48, 152, 234, 30, 57, 96, 46, 202, 226, 232, 7, 47,
+    76, 193, 92, 240, 180, 29, 163, 78, 146, 205, 130, 167, 251, 253, 141, 106,
+    249, 207, 99, 118, 149, 164, 246, 52, 17, 14, 192, 242, 150, 233, 124, 90,
+    94, 37, 21, 75, 206, 175, 241, 104, 190, 169, 13, 129, 61, 87, 187, 4,
+    248, 3, 114, 45, 98, 16, 50, 201, 161, 185, 182, 200, 215, 38, 112, 109,
+    108, 208, 198, 220, 216, 218, 86, 166, 134, 236, 5, 85, 228, 137, 117, 237,
+    81, 138, 225, 222, 59, 43, 197, 49, 139, 136, 213, 25, 31, 176, 173, 120,
+    171, 20, 147, 221, 209, 63, 72, 143, 157, 64, 239, 113, 126, 162, 2, 188,
+    62, 204, 42, 196, 24, 191, 121, 243, 235, 89, 26, 151, 44, 79, 189, 133,
+    168, 23, 203, 174, 35, 219, 250, 11, 123, 82, 18, 110, 125, 40, 103, 83,
+    67, 159, 227, 19, 55, 255, 178, 77, 107, 1, 156, 111, 88, 199, 127, 247,
+    135, 84, 148, 34, 172, 15, 245, 119, 217, 179, 80, 105, 212, 116, 69, 142,
+    132, 153, 65, 71, 74, 100, 184, 53, 51, 10, 181, 60, 22, 122, 8, 93
+  };
+
+  static void fade(LED& led, uint8_t keep)
+  {
+    led = scale8(led, keep);
+  }
+
+  uint8_t noise8(uint16_t x)
+  {
+    uint8_t i = x >> 8;
+    uint8_t f = x;
+    uint8_t a = pgm_read_byte(&__NOISE_PERM[i]);
+    uint8_t b = pgm_read_byte(&__NOISE_PERM[(uint8_t)(i + 1u)]);
+    // smoothstep 3f^2 - 2f^3 in 32 bits, rounding f^2 first made it step back
+    uint8_t s = ((uint32_t)f * f * (768u - 2u * f)) >> 16;
+    return lerp8(a, b, s);
+  }
+
+  Effect::Effect(Strip* strip) : strip{strip}, group{nullptr} {}
+
+  Effect::Effect(StripGroup* group) : strip{nullptr}, group{group} {}
+
+  uint32_t Effect::numPixels() const
+  {
+    if (strip) return strip->numPixels();
+    if (group) return group->numPixels();
+    return 0u;
+  }
+
+  // strips of a group are walked one after another, reversed ones from their end
+  template <typename F>
+  void Effect::each(F f)
+  {
+    Strip* s = strip ? strip : group ? group->getStripPtr(0) : nullptr;
+    uint16_t count = strip ? 1u : group ? group->numStrips() : 0u;
+    uint32_t first = 0u;
+    for (; s && count; --count, ++s)
+    {
+      if (s->leds)
+      {
+        s->dirty = true;
+        LED* p = s->reverse ? s->leds + (s->count - 1) : s->leds;
+        int8_t step = s->reverse ? -1 : 1;
+        for (uint16_t k = 0; k < s->count; ++k, p += step) f(*p, first + k);
+      }
+      first += s->count;
+    }
+  }
+
+  static void setPixel(Strip* strip, StripGroup* group, uint32_t n, const Color& color)
+  {
+    if (strip) strip->setPixelColor((uint16_t)n, color);
+    else if (group) group->setPixelColor(n, color);
+  }
+
+  Fire::Fire(uint8_t* heat, Strip* strip) : Effect(strip), cooling{55u}, sparking{120u}, heat{heat} {}
+
+  Fire::Fire(uint8_t* heat, StripGroup* group) : Effect(group), cooling{55u}, sparking{120u}, heat{heat} {}
+
+  void Fire::render()
+  {
+    uint32_t n = numPixels();
+    if (heat == nullptr || n == 0u) return;
+
+    uint32_t cool = (cooling * 10u) / n + 2u;
+    uint8_t cool_max = cool > 255u ? 255u : cool;
+    for (uint32_t i = 0; i < n; ++i) heat[i] = qsub8(heat[i], random8(cool_max));
+
+    // heat drifts up, (a + 2b) / 3 without a division
+    for (uint32_t k = n - 1u; k >= 2u; --k) heat[k] = ((heat[k - 1u] + 2u * heat[k - 2u]) * 85u) >> 8;
+
+    if (random8() < sparking)
+    {
+      uint8_t y = random8(n < 7u ? (uint8_t)n : 7u);
+      heat[y] = qadd8(heat[y], 160u + random8(96u));
+    }
+
+    Palette16 p;
+    p.load_P(PALETTE_HEAT);
+    // 240 keeps the hottest LEDs off the wrap back to black
+    each([&](LED& led, uint32_t i) { led = p.get(scale8(heat[i], 240u), 255u, true); });
+  }
+
+  Twinkle::Twinkle(Strip* strip, const Color& color, uint8_t density, uint8_t fade)
+  : Effect(strip), palette{nullptr}, color{color}, density{density}, fade{fade} {}
+
+  Twinkle::Twinkle(StripGroup* group, const Color& color, uint8_t density, uint8_t fade)
+  : Effect(group), palette{nullptr}, color{color}, density{density}, fade{fade} {}
+
+  void Twinkle::render()
+  {
+    uint32_t n = numPixels();
+    if (n == 0u) return;
+
+    uint8_t keep = 255u - fade;
+    each([&](LED& led, uint32_t) { WS2812B::fade(led, keep); });
+
+    uint8_t count = density >> 4;
+    if (random8() < (uint8_t)(density << 4)) ++count;
+    while (count--)
+    {
+      uint32_t i = (random16() * n) >> 16;
+      setPixel(strip, group, i, palette ? colorFromPalette_P(palette, random8()) : color);
+    }
+  }
+
+  Comet::Comet(Strip* strip, const Color& color, uint8_t size, int16_t speed)
+  : Effect(strip), color{color}, size{size}, speed{speed}, trail{48u}, sparkle{true}, pos{0} {}
+
+  Comet::Comet(StripGroup* group, const Color& color, uint8_t size, int16_t speed)
+  : Effect(group), color{color}, size{size}, speed{speed}, trail{48u}, sparkle{true}, pos{0} {}
+
+  void Comet::render()
+  {
+    uint32_t n = numPixels();
+    if (n == 0u) return;
+
+    uint8_t keep = 255u - trail;
+    each([&](LED& led, uint32_t) { if (!sparkle || (random8() & 1u)) WS2812B::fade(led, keep); });
+
+    uint32_t head = pos >> 8;
+    for (uint8_t k = 0; k < size && head + k < n; ++k) setPixel(strip, group, head + k, color);
+
+    // bounce between the ends, the head stays inside the line
+    int32_t limit = n > size ? (int32_t)(n - size) << 8 : 0;
+    pos += speed;
+    if (pos < 0)
+    {
+      pos = -pos;
+      speed = -speed;
+    }
+    if (pos > limit)
+    {
+      pos = 2 * limit - pos;
+      speed = -speed;
+      if (pos < 0) pos = 0;
+    }
+  }
+
+  TheaterChase::TheaterChase(Strip* strip, const Color& color, uint8_t spacing, const Color& background)
+  : Effect(strip), color{color}, background{background}, spacing{spacing}, phase{0u} {}
+
+  TheaterChase::TheaterChase(StripGroup* group, const Color& color, uint8_t spacing, const Color& background)
+  : Effect(group), color{color}, background{background}, spacing{spacing}, phase{0u} {}
+
+  void TheaterChase::render()
+  {
+    uint8_t every = spacing ? spacing : 1u;
+    if (phase >= every) phase = 0u;
+    uint8_t k = phase;
+    each([&](LED& led, uint32_t) {
+      led = k ? background : color;
+      if (++k == every) k = 0u;
+    });
+    phase = phase ? phase - 1u : every - 1u;
+  }
+
+  Breathing::Breathing(Strip* strip, const Color& color, uint16_t period, uint8_t min_level)
+  : Effect(strip), color{color}, period{period}, min_level{min_level}, phase{0u} {}
+
+  Breathing::Breathing(StripGroup* group, const Color& color, uint16_t period, uint8_t min_level)
+  : Effect(group), color{color}, period{period}, min_level{min_level}, phase{0u} {}
+
+  void Breathing::render()
+  {
+    // sine from its minimum, so a breath starts dark
+    uint8_t level = min_level + scale8(sin8((phase >> 8) + 192u), 255u - min_level);
+    Color c = scale8(color, level);
+    if (strip) strip->fill(c);
+    else if (group) group->fill(c);
+    phase += period ? (uint16_t)(65536ul / period) : 0u;
+  }
+
+  Noise::Noise(Strip* strip, const uint32_t* palette, uint16_t scale, uint16_t speed)
+  : Effect(strip), palette{palette}, scale{scale}, speed{speed}, offset{0u} {}
+
+  Noise::Noise(StripGroup* group, const uint32_t* palette, uint16_t scale, uint16_t speed)
+  : Effect(group), palette{palette}, scale{scale}, speed{speed}, offset{0u} {}
+
+  void Noise::render()
+  {
+    if (palette == nullptr) return;
+    Palette16 p;
+    p.load_P(palette);
+    uint16_t x = offset;
+    each([&](LED& led, uint32_t) {
+      led = p.get(noise8(x), 255u, true);
+      x += scale;
+    });
+    offset += speed;
+  }
+}
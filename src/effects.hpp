@@ -0,0 +1,141 @@
+#pragma once
+#include "ws2812b.hpp"
+
+/**
+ * Standard effects for a Strip or a StripGroup, LEDs in logical order (reverse is honored and
+ * a group is one continuous line). Every render() draws one frame and advances the effect by
+ * one step, so the speed follows the frame rate (see FrameScheduler). The effect object is the
+ * state; keep it static, no memory is allocated. Random effects draw from random16() of
+ * math8.hpp, seed it with random16Seed().
+ *
+ * RAM on AVR is the object size (+ the caller buffer) and the stack used by render(), 300 LEDs.
+ * bench/bench_effects.cpp times render() on the host.
+ */
+
+namespace WS2812B
+{
+  class Effect
+  {
+  public:
+    Effect(Strip* strip);
+    Effect(StripGroup* group);
+    uint32_t numPixels() const;
+
+  protected:
+    // f(LED& led, uint32_t index) for every LED
+    template <typename F>
+    void each(F f);
+    Strip* strip;
+    StripGroup* group;
+  };
+
+  /**
+   * Heat simulation, one heat byte per LED in the caller buffer, colors from PALETTE_HEAT.
+   * RAM: 8 B + heat 300 B, 48 B stack.
+   */
+  class Fire : public Effect
+  {
+  public:
+    Fire(uint8_t* heat, Strip* strip);
+    Fire(uint8_t* heat, StripGroup* group);
+    void render();
+    uint8_t cooling; // heat lost per frame, 20 - 100
+    uint8_t sparking; // chance of a new spark per frame / 256
+
+  private:
+    uint8_t* heat;
+  };
+
+  /**
+   * Random LEDs light up and fade out, color or random palette entries.
+   * RAM: 10 B.
+   */
+  class Twinkle : public Effect
+  {
+  public:
+    Twinkle(Strip* strip, const Color& color, uint8_t density = 8u, uint8_t fade = 16u);
+    Twinkle(StripGroup* group, const Color& color, uint8_t density = 8u, uint8_t fade = 16u);
+    void render();
+    const uint32_t* palette; // PROGMEM palette, used instead of color when set
+    Color color;
+    uint8_t density; // new LEDs per frame / 16
+    uint8_t fade; // brightness lost per frame / 256
+  };
+
+  /**
+   * Head of size LEDs moving with a fading, sparkling trail; bounces at the ends.
+   * RAM: 14 B.
+   */
+  class Comet : public Effect
+  {
+  public:
+    Comet(Strip* strip, const Color& color, uint8_t size = 4u, int16_t speed = 256);
+    Comet(StripGroup* group, const Color& color, uint8_t size = 4u, int16_t speed = 256);
+    void render();
+    Color color;
+    uint8_t size;
+    int16_t speed; // LEDs per frame, 8.8 fixed point
+    uint8_t trail; // brightness lost by the trail per frame / 256
+    bool sparkle; // trail LEDs decay at random
+
+  private:
+    int32_t pos; // 8.8 fixed point
+  };
+
+  /**
+   * Every spacing-th LED lit, moving one LED every frame.
+   * RAM: 12 B.
+   */
+  class TheaterChase : public Effect
+  {
+  public:
+    TheaterChase(Strip* strip, const Color& color, uint8_t spacing = 3u, const Color& background = Color{0u});
+    TheaterChase(StripGroup* group, const Color& color, uint8_t spacing = 3u, const Color& background = Color{0u});
+    void render();
+    Color color;
+    Color background;
+    uint8_t spacing;
+
+  private:
+    uint8_t phase;
+  };
+
+  /**
+   * Whole line pulsing along a sine between min_level and 255.
+   * RAM: 12 B.
+   */
+  class Breathing : public Effect
+  {
+  public:
+    Breathing(Strip* strip, const Color& color, uint16_t period = 256u, uint8_t min_level = 16u);
+    Breathing(StripGroup* group, const Color& color, uint16_t period = 256u, uint8_t min_level = 16u);
+    void render();
+    Color color;
+    uint16_t period; // frames per breath
+    uint8_t min_level;
+
+  private:
+    uint16_t phase;
+  };
+
+  /**
+   * Smooth 1D value noise mapped through a palette and scrolled over time.
+   * RAM: 12 B, 48 B stack.
+   */
+  class Noise : public Effect
+  {
+  public:
+    Noise(Strip* strip, const uint32_t* palette, uint16_t scale = 32u, uint16_t speed = 16u);
+    Noise(StripGroup* group, const uint32_t* palette, uint16_t scale = 32u, uint16_t speed = 16u);
+    void render();
+    const uint32_t* palette; // PROGMEM
+    uint16_t scale; // noise step between LEDs, 8.8 fixed point
+    uint16_t speed; // noise step per frame, 8.8 fixed point
+
+  private:
+    uint32_t offset;
+  };
+
+  // smooth value noise of x (8.8 fixed point), 0 - 255
+  uint8_t noise8(uint16_t x);
+}
@@ -2,169 +2,156 @@
 
 #include "ws2812b.hpp"
 #include <driver/rmt.h>
+#include "rmt.hpp"
 
-#if F_CPU == 240000000L
+struct RmtChannel
+{
+  uint8_t pin;
+  uint16_t scale; // bright, 256 sends the bytes unchanged
+  volatile uint32_t end_time;
+};
+
+static RmtChannel channels[WS2812B_RMT_CHANNELS];
+static uint8_t used_channels = 0u;
+static void (*show_done_callback)(uint8_t pin) = nullptr;
 
-#define WS2812B_RMT_CLK_DIV 6
+static void IRAM_ATTR rmtTranslate(const void* src, rmt_item32_t* dest, size_t src_size, size_t wanted_num, size_t* translated_size, size_t* item_num)
+{
+  if (src == nullptr || dest == nullptr)
+  {
+    *translated_size = 0;
+    *item_num = 0;
+    return;
+  }
 
-#elif F_CPU == 160000000L
+  void* context = nullptr;
+  rmt_translator_get_context(item_num, &context);
+  uint16_t scale = context ? ((RmtChannel*)context)->scale : 256u;
+  *translated_size = WS2812B::rmt::encode((const uint8_t*)src, src_size, scale, dest, wanted_num, item_num);
+}
 
-#define WS2812B_RMT_CLK_DIV 4
+// runs in the RMT interrupt, so does the callback of onShowDone()
+static void IRAM_ATTR rmtTxEnd(rmt_channel_t channel, void*)
+{
+  channels[channel].end_time = micros();
+  if (show_done_callback) show_done_callback(channels[channel].pin);
+}
 
-#elif F_CPU == 80000000L
+static RmtChannel* channelFor(uint8_t pin)
+{
+  for (uint8_t i = 0; i < used_channels; ++i)
+  {
+    if (channels[i].pin == pin) return &channels[i];
+  }
+  if (used_channels >= WS2812B_RMT_CHANNELS) return nullptr;
+
+  rmt_channel_t channel = (rmt_channel_t)used_channels;
+  rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin, channel);
+  config.clk_div = WS2812B_RMT_CLK_DIV;
+  if (rmt_config(&config) != ESP_OK) return nullptr;
+  if (rmt_driver_install(channel, 0, 0) != ESP_OK) return nullptr;
+
+  RmtChannel* ch = &channels[used_channels++];
+  ch->pin = pin;
+  ch->scale = 256u;
+  ch->end_time = 0u;
+  rmt_translator_init(channel, rmtTranslate);
+  rmt_translator_set_context(channel, ch);
+  if (used_channels == 1) rmt_register_tx_end_callback(rmtTxEnd, nullptr);
+  return ch;
+}
 
-#define WS2812B_RMT_CLK_DIV 2
+static RmtChannel* findChannel(uint8_t pin)
+{
+  for (uint8_t i = 0; i < used_channels; ++i)
+  {
+    if (channels[i].pin == pin) return &channels[i];
+  }
+  return nullptr;
+}
 
-#else
+namespace WS2812B
+{
 
-#define WS2812B_RMT_CLK_DIV 1
+  static void sendBytes(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint16_t scale)
+  {
+    if (bytes == nullptr || num_bytes == 0) return;
 
-#error "Only 240, 160 or 80 MHz F_CPU are supported, sorry."
+    RmtChannel* ch = channelFor(pin);
+    if (ch == nullptr) return;
+    rmt_channel_t channel = (rmt_channel_t)(ch - channels);
 
-#endif
+    rmt_wait_tx_done(channel, portMAX_DELAY); // previous frame still on the wire
+    uint32_t elapsed = micros() - ch->end_time;
+    if (elapsed < 50ul) delayMicroseconds(50ul - elapsed);
 
-static unsigned long endTime = 0u;
+    ch->scale = scale;
+    rmt_write_sample(channel, bytes, num_bytes, false);
+  }
 
-static bool canShow()
-{
-  unsigned long now = micros();
-  if (endTime > now) {
-    endTime = now;
+  // transmission ends asynchronously, latch time is tracked per RMT channel instead of timer
+  void _extern_timer_show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright, uint32_t&)
+  {
+    sendBytes((const uint8_t*)leds, len * 3, pin, bright);
   }
-  return (now - endTime) > 50L;
-}
 
-static portMUX_TYPE show_mux = portMUX_INITIALIZER_UNLOCKED;
+  void _extern_timer_show_raw(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint32_t&)
+  {
+    sendBytes(bytes, num_bytes, pin, 256u);
+  }
 
+  void _extern_timer_show_bytes(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint8_t bright, uint32_t&)
+  {
+    sendBytes(bytes, num_bytes, pin, bright);
+  }
 
-namespace WS2812B
-{
+  bool _extern_can_show(uint8_t pin, uint32_t)
+  {
+    RmtChannel* ch = findChannel(pin);
+    if (ch == nullptr) return true;
+    if (rmt_wait_tx_done((rmt_channel_t)(ch - channels), 0) != ESP_OK) return false;
+    return micros() - ch->end_time >= 50ul;
+  }
 
   void show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright)
   {
-    if (leds == nullptr) return;
-    
-    volatile uint8_t* bytes = (volatile uint8_t*)leds;
-    volatile uint16_t num_bytes = len * 3;
+    _extern_timer_show(leds, len, pin, bright, pinTimer(pin));
+  }
+
+  void waitShowDone(uint8_t pin)
+  {
+    RmtChannel* ch = findChannel(pin);
+    if (ch) rmt_wait_tx_done((rmt_channel_t)(ch - channels), portMAX_DELAY);
+  }
+
+  void waitShowDone()
+  {
+    for (uint8_t i = 0; i < used_channels; ++i) rmt_wait_tx_done((rmt_channel_t)i, portMAX_DELAY);
+  }
 
+  void onShowDone(void (*callback)(uint8_t pin))
+  {
+    show_done_callback = callback;
+  }
 
-    uint32_t gpio_mask = (1 << pin);
-    volatile uint32_t* gpio_reg = (volatile uint32_t*)0x3FF44004;
+  // the channel is claimed here so running out of them shows up in begin() and not as silently dropped frames
+  bool _extern_begin(uint8_t pin)
+  {
+    return channelFor(pin) != nullptr;
+  }
 
-#ifdef FREERTOS_CONFIG_H
-    if (xPortGetCoreID() == 1) taskENTER_CRITICAL(&show_mux);
-#else
-    // zablokowanie przerwań w inny sposób
-#endif
+  uint8_t _extern_pin_port(uint8_t)
+  {
+    return 0;
+  }
 
-    asm volatile (
-      "mov t1, %[num_bytes]\n"        // Załaduj długość (liczba LED-ów) do rejestru t1
-      "beqz t1, 4f\n"           // Jeśli num_bytes == 0, zakończ
-
-      "li t2, 3\n"              // T2 = 3 (trzy bajty na LED: G, R, B)
-
-      // Pętla dla każdego LED-a
-      "1:\n"
-      "li t3, 8\n"              // Przygotowanie do wysyłania 8 bitów dla każdej składowej
-
-      // Wczytanie i przeskalowanie zielonego bajtu
-      "lbu t0, 0(%[bytes])\n"   // Załaduj zielony bajt
-      "mulhu t0, t0, %[bright]\n" // Skalowanie jasności
-      "slli t0, t0, 1\n"        // Przesunięcie bitu
-
-      // Wysłanie zielonego bajtu
-      "2:\n"
-      "bltz t0, 3f\n"           // Jeśli najstarszy bit to 1, przejdź do wysyłania '1'
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"  // Ustaw GPIO na wysoki stan (wysyłanie '0')
-      "nop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "j 5f\n"                  // Przejdź do końca bloku bitu '0'
-
-      // Wysłanie bitu '1'
-      "3:\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-
-      // Zmniejszenie licznika bitów i przetwarzanie następnego bitu
-      "5:\n"
-      "addi t3, t3, -1\n"
-      "bnez t3, 2b\n"           // Jeśli są jeszcze bity do wysłania, powrót do etykiety "2"
-
-      // Przejdź do czerwonego bajtu
-      "addi %[bytes], %[bytes], 1\n" // Przesuń wskaźnik do następnej składowej
-
-      "li t3, 8\n"              // Przygotowanie do wysyłania 8 bitów dla każdej składowej
-      "lbu t0, 0(%[bytes])\n"   // Załaduj czerwony bajt
-      "mulhu t0, t0, %[bright]\n" // Skalowanie jasności
-      "slli t0, t0, 1\n"        // Przesunięcie bitu
-      "2:\n"
-      "bltz t0, 3f\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "j 5f\n"
-      "3:\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "5:\n"
-      "addi t3, t3, -1\n"
-      "bnez t3, 2b\n"
-
-      // Przejdź do niebieskiego bajtu
-      "addi %[bytes], %[bytes], 1\n"
-      "li t3, 8\n"
-      "lbu t0, 0(%[bytes])\n"
-      "mulhu t0, t0, %[bright]\n"
-      "slli t0, t0, 1\n"
-      "2:\n"
-      "bltz t0, 3f\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "j 5f\n"
-      "3:\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "sw %[gpio_mask], 0(%[gpio_reg])\n"
-      "nop\nnop\nnop\n"
-      "not %[gpio_mask], %[gpio_mask]\n"
-      "5:\n"
-      "addi t3, t3, -1\n"
-      "bnez t3, 2b\n"
-
-      // Przejdź do następnego LED-a
-      "addi %[bytes], %[bytes], 1\n"  // Przesuń wskaźnik do następnego LED-a (kolejny bajt)
-      "addi t1, t1, -1\n"             // Zmniejsz licznik LED-ów
-      "bnez t1, 1b\n"                 // Jeśli są jeszcze LED-y, wróć do początku pętli
-
-      // Koniec transmisji
-      "4:\n"
-
-      : [bytes] "+r" (bytes), [gpio_mask] "+r" (gpio_mask)
-      : [gpio_reg] "r" (gpio_reg), [num_bytes] "r" (num_bytes), [bright] "r" (bright)
-      : "t0", "t1", "t2", "t3", "memory"
-    );
+  // every pin has its own RMT channel and show() only queues the frame, so the strips are sent in parallel without the buffer
+  void _extern_parallel_show(Strip* const* strips, uint8_t n, uint8_t bright, uint8_t*, uint16_t)
+  {
+    for (uint8_t s = 0; s < n; ++s) _extern_timer_show(strips[s]->leds, strips[s]->count, strips[s]->pin, bright, strips[s]->timer);
   }
 
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,310 @@
+#ifdef WS2812B_HOST
+
+#include "ws2812b.hpp"
+#include "timing.hpp"
+#include <vector>
+
+/**
+ * The simulated transmitter replays the cycle counts of the AVR loops (timing.hpp) at
+ * WS2812B_HOST_F_CPU, including the longer low phase between bytes, so the recorded
+ * waveform is the one an AVR at that clock sends. decode() checks it against the windows
+ * of timing.hpp.
+ */
+using HostLoop = WS2812B::timing::SerialLoop<WS2812B_HOST_F_CPU>;
+using HostRawLoop = WS2812B::timing::SerialRawLoop<WS2812B_HOST_F_CPU>;
+using HostParallelLoop = WS2812B::timing::ParallelLoop<WS2812B_HOST_F_CPU>;
+
+#define WS2812B_HOST_LATCH_NS 50000u
+
+static uint64_t now_ns = 0u;
+static uint32_t latch_waits = 0u;
+static std::vector<WS2812B::host::Edge> pin_edges[256];
+static uint32_t pin_frames[256];
+static uint64_t pin_end[256];
+static uint8_t pin_levels[256];
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin_levels[pin] == value) return;
+  pin_levels[pin] = value;
+  pin_edges[pin].push_back({now_ns, value});
+}
+
+unsigned long micros()
+{
+  return (unsigned long)(now_ns / 1000u);
+}
+
+unsigned long millis()
+{
+  return (unsigned long)(now_ns / 1000000u);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  now_ns += (uint64_t)us * 1000u;
+}
+
+// built with ESP32 too, esp32.cpp is the backend and runs on a stubbed RMT driver (test/stub)
+#ifndef ESP32
+
+static void (*show_done_callback)(uint8_t pin) = nullptr;
+
+// latch is tracked per pin with ns resolution, the us timer of the caller would round it down
+static void waitLatch(uint8_t pin)
+{
+  if (pin_frames[pin] == 0 || now_ns >= pin_end[pin] + WS2812B_HOST_LATCH_NS) return;
+  // the real backends spin here, the simulation jumps to the end of the latch instead
+  now_ns = pin_end[pin] + WS2812B_HOST_LATCH_NS;
+  ++latch_waits;
+}
+
+// time is kept in cycles and converted per edge, so rounding doesn't accumulate over a frame
+static uint64_t cycleTime(uint64_t start, uint64_t cycles)
+{
+  return start + cycles * 1000000000ull / WS2812B_HOST_F_CPU;
+}
+
+// records one frame starting at start, returns its duration in ns
+// scale is the brightness, 256 records the bytes unchanged
+template <typename LOOP>
+static uint64_t record(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint16_t scale, uint64_t start)
+{
+  std::vector<WS2812B::host::Edge>& e = pin_edges[pin];
+  uint64_t c = 0;
+  for (uint16_t i = 0; i < num_bytes; ++i)
+  {
+    if (i) c += LOOP::gap;
+    uint8_t b = (uint8_t)((bytes[i] * scale) >> 8);
+    for (uint8_t mask = 0x80; mask; mask >>= 1)
+    {
+      bool one = b & mask;
+      e.push_back({cycleTime(start, c), HIGH});
+      e.push_back({cycleTime(start, c + (one ? LOOP::t1h : LOOP::t0h)), LOW});
+      c += LOOP::period;
+    }
+  }
+  uint64_t end = cycleTime(start, c);
+  pin_levels[pin] = LOW;
+  pin_end[pin] = end;
+  ++pin_frames[pin];
+  return end - start;
+}
+
+// records the bits of one pin of a staged parallel frame (transposeFrame), returns the end time
+static uint64_t recordParallel(const uint8_t* values, uint16_t count, uint8_t mask, uint8_t pin, uint64_t start)
+{
+  std::vector<WS2812B::host::Edge>& e = pin_edges[pin];
+  uint64_t c = 0;
+  for (uint16_t i = 0; i < count; ++i, c += HostParallelLoop::period)
+  {
+    e.push_back({cycleTime(start, c), HIGH});
+    e.push_back({cycleTime(start, c + ((values[i] & mask) ? HostParallelLoop::t1h : HostParallelLoop::t0h)), LOW});
+  }
+  uint64_t end = cycleTime(start, c);
+  pin_levels[pin] = LOW;
+  pin_end[pin] = end;
+  ++pin_frames[pin];
+  return end;
+}
+
+namespace WS2812B
+{
+
+  void _extern_timer_show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright, uint32_t& timer)
+  {
+    if (leds == nullptr) return;
+    waitLatch(pin);
+    now_ns += record<HostLoop>((const uint8_t*)leds, len * 3, pin, bright, now_ns);
+    timer = micros();
+    if (show_done_callback) show_done_callback(pin);
+  }
+
+  void _extern_timer_show_raw(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint32_t& timer)
+  {
+    if (bytes == nullptr) return;
+    waitLatch(pin);
+    now_ns += record<HostRawLoop>(bytes, num_bytes, pin, 256u, now_ns);
+    timer = micros();
+    if (show_done_callback) show_done_callback(pin);
+  }
+
+  void _extern_timer_show_bytes(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint8_t bright, uint32_t& timer)
+  {
+    if (bytes == nullptr) return;
+    waitLatch(pin);
+    now_ns += record<HostLoop>(bytes, num_bytes, pin, bright, now_ns);
+    timer = micros();
+    if (show_done_callback) show_done_callback(pin);
+  }
+
+  bool _extern_can_show(uint8_t pin, uint32_t)
+  {
+    return pin_frames[pin] == 0 || now_ns >= pin_end[pin] + WS2812B_HOST_LATCH_NS;
+  }
+
+  void show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright)
+  {
+    _extern_timer_show(leds, len, pin, bright, pinTimer(pin));
+  }
+
+  void waitShowDone(uint8_t) {}
+
+  void waitShowDone() {}
+
+  void onShowDone(void (*callback)(uint8_t pin))
+  {
+    show_done_callback = callback;
+  }
+
+  bool _extern_begin(uint8_t)
+  {
+    return true;
+  }
+
+  // pins are grouped in 8-bit ports like on AVR
+  uint8_t _extern_pin_port(uint8_t pin)
+  {
+    return pin >> 3;
+  }
+
+  // same staging and fallback as the AVR backend, the staged port values are replayed per pin
+  void _extern_parallel_show(Strip* const* strips, uint8_t n, uint8_t bright, uint8_t* buffer, uint16_t size)
+  {
+    uint8_t masks[WS2812B_PARALLEL_MAX];
+    const uint8_t* ptrs[WS2812B_PARALLEL_MAX];
+    uint16_t lens[WS2812B_PARALLEL_MAX];
+    uint8_t all = 0;
+    bool collision = false;
+    for (uint8_t s = 0; s < n; ++s)
+    {
+      masks[s] = (uint8_t)(1u << (strips[s]->pin & 7u));
+      if (all & masks[s] || strips[s]->leds == nullptr) collision = true;
+      all |= masks[s];
+      ptrs[s] = (const uint8_t*)strips[s]->leds;
+      lens[s] = strips[s]->count * 3;
+    }
+
+    uint16_t count = (n < 2 || collision) ? 0 : transposeFrame(ptrs, lens, masks, n, bright, buffer, size);
+    if (count == 0)
+    {
+      for (uint8_t s = 0; s < n; ++s) _extern_timer_show(strips[s]->leds, strips[s]->count, strips[s]->pin, bright, strips[s]->timer);
+      return;
+    }
+
+    for (uint8_t s = 0; s < n; ++s) waitLatch(strips[s]->pin);
+    uint64_t end = 0;
+    for (uint8_t s = 0; s < n; ++s) end = recordParallel(buffer, count, masks[s], strips[s]->pin, now_ns);
+    now_ns = end;
+
+    for (uint8_t s = 0; s < n; ++s)
+    {
+      strips[s]->timer = micros();
+      if (show_done_callback) show_done_callback(strips[s]->pin);
+    }
+  }
+
+}
+
+#endif // ESP32
+
+namespace WS2812B
+{
+  namespace host
+  {
+    uint64_t now()
+    {
+      return now_ns;
+    }
+
+    void advance(uint32_t us)
+    {
+      now_ns += (uint64_t)us * 1000u;
+    }
+
+    void advanceNs(uint32_t ns)
+    {
+      now_ns += ns;
+    }
+
+    void reset()
+    {
+      now_ns = 0u;
+      latch_waits = 0u;
+      for (uint16_t i = 0; i < 256; ++i)
+      {
+        pin_edges[i].clear();
+        pin_frames[i] = 0u;
+        pin_end[i] = 0u;
+        pin_levels[i] = LOW;
+      }
+    }
+
+    const Edge* edges(uint8_t pin, size_t& count)
+    {
+      count = pin_edges[pin].size();
+      return pin_edges[pin].data();
+    }
+
+    void clearEdges(uint8_t pin)
+    {
+      pin_edges[pin].clear();
+    }
+
+    int32_t decode(uint8_t pin, uint8_t* bytes, uint16_t max)
+    {
+      const std::vector<Edge>& e = pin_edges[pin];
+
+      // first rising edge after the last latch gap
+      size_t first = 0;
+      for (size_t i = 2; i < e.size(); i += 2)
+      {
+        if (e[i].time - e[i - 1].time >= WS2812B_HOST_LATCH_NS) first = i;
+      }
+
+      int32_t count = 0;
+      uint8_t byte = 0, bits = 0;
+      for (size_t i = first; i + 1 < e.size(); i += 2)
+      {
+        if (e[i].level != HIGH || e[i + 1].level != LOW) return -1;
+        uint64_t high = e[i + 1].time - e[i].time;
+        bool last = i + 2 >= e.size();
+        uint64_t low = last ? 0u : e[i + 2].time - e[i + 1].time;
+
+        bool one;
+        if (high >= timing::T0H_MIN && high <= timing::T0H_MAX) one = false;
+        else if (high >= timing::T1H_MIN && high <= timing::T1H_MAX) one = true;
+        else return -1;
+
+        if (!last)
+        {
+          if (low < (one ? timing::T1L_MIN : timing::T0L_MIN) || low > timing::TL_MAX) return -1;
+        }
+
+        byte = (uint8_t)((byte << 1) | one);
+        if (++bits == 8)
+        {
+          if (count >= max) return count;
+          bytes[count++] = byte;
+          byte = 0, bits = 0;
+        }
+      }
+      return bits ? -1 : count;
+    }
+
+    uint32_t framesSent(uint8_t pin)
+    {
+      return pin_frames[pin];
+    }
+
+    uint32_t latchWaits()
+    {
+      return latch_waits;
+    }
+  }
+
+}
+
+#endif // WS2812B_HOST
@@ -0,0 +1,58 @@
+#pragma once
+
+// Arduino shims used by the library when it is built for a workstation (-DWS2812B_HOST)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// clock of the simulated AVR transmit loop
+#ifndef WS2812B_HOST_F_CPU
+#define WS2812B_HOST_F_CPU 16000000ul
+#endif
+
+#define PROGMEM
+#define OUTPUT 0x1
+#define LOW 0x0
+#define HIGH 0x1
+
+inline uint8_t pgm_read_byte(const void* addr) { return *(const uint8_t*)addr; }
+inline uint16_t pgm_read_word(const void* addr) { return *(const uint16_t*)addr; }
+inline uint32_t pgm_read_dword(const void* addr) { return *(const uint32_t*)addr; }
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+unsigned long micros();
+unsigned long millis();
+void delayMicroseconds(unsigned int us);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+namespace WS2812B
+{
+  namespace host
+  {
+    struct Edge
+    {
+      uint64_t time; // ns
+      uint8_t level;
+    };
+
+    // simulated clock, only moves forward through advance() and transmissions
+    uint64_t now();
+    void advance(uint32_t us);
+    void advanceNs(uint32_t ns);
+    void reset();
+
+    const Edge* edges(uint8_t pin, size_t& count);
+    void clearEdges(uint8_t pin);
+
+    // decodes the last frame sent on pin back to wire bytes, -1 if any bit is out of the
+    // T0H/T1H/T0L/T1L windows of timing.hpp or a low phase is too long for a bit but too short for a latch
+    int32_t decode(uint8_t pin, uint8_t* bytes, uint16_t max);
+
+    uint32_t framesSent(uint8_t pin);
+    uint32_t latchWaits();
+  }
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include "ws2812b.hpp"
+
+/**
+ * 8-bit fixed point helpers. scale arguments are fractions of 256 with 255 as identity:
+ * scale8(x, 255) == x, scale8(x, 128) == x / 2.
+ *
+ * On AVR scale8, scale8_video, qadd8 and qsub8 are a few instructions of inline asm (one
+ * hardware mul, no 16-bit promotion); elsewhere they are constexpr.
+ */
+
+#if defined(AVR) && !defined(WS2812B_HOST)
+#define WS2812B_MATH8_ASM 1
+#else
+#define WS2812B_MATH8_ASM 0
+#endif
+
+// 127 * sin() of the first quarter turn, 64 steps + the peak
+static const uint8_t PROGMEM __SIN8_QUARTER[65] = {
+  0, 3, 6, 9, 12, 16, 19, 22, 25, 28, 31, 34, 37, 40, 43, 46, 49, 51, 54, 57, 60, 63, 65, 68, 71, 73, 76, 78, 81, 83, 85, 88,
+  90, 92, 94, 96, 98, 100, 102, 104, 106, 107, 109, 111, 112, 113, 115, 116, 117, 118, 120, 121, 122, 122, 123, 124, 125, 125, 126, 126, 126, 127, 127, 127, 127
+};
+
+namespace WS2812B
+{
+
+#if WS2812B_MATH8_ASM
+
+  inline uint8_t scale8(uint8_t i, uint8_t scale)
+  {
+    // r1:r0 = i * scale, + i -> i * (scale + 1), high byte
+    asm volatile(
+      "mul  %0, %1"           "\n\t"
+      "add  r0, %0"           "\n\t"
+      "ldi  %0, 0x00"         "\n\t"
+      "adc  %0, r1"           "\n\t"
+      "clr  __zero_reg__"     "\n\t"
+      : "+a" (i)
+      : "a" (scale)
+      : "r0", "r1"
+    );
+    return i;
+  }
+
+  inline uint8_t scale8_video(uint8_t i, uint8_t scale)
+  {
+    uint8_t j = 0;
+    asm volatile(
+      "tst  %[i]"             "\n\t"
+      "breq 1f"               "\n\t"
+      "mul  %[i], %[scale]"   "\n\t"
+      "mov  %[j], r1"         "\n\t"
+      "clr  __zero_reg__"     "\n\t"
+      "cpse %[scale], r1"     "\n\t" /* r1 == 0 here, +1 when scale != 0 */
+      "subi %[j], 0xFF"       "\n\t"
+      "1:"                    "\n\t"
+      : [j] "+a" (j)
+      : [i] "a" (i), [scale] "a" (scale)
+      : "r0", "r1"
+    );
+    return j;
+  }
+
+  inline uint8_t qadd8(uint8_t i, uint8_t j)
+  {
+    asm volatile(
+      "add  %0, %1"           "\n\t"
+      "brcc 1f"               "\n\t"
+      "ldi  %0, 0xFF"         "\n\t"
+      "1:"                    "\n\t"
+      : "+a" (i)
+      : "a" (j)
+    );
+    return i;
+  }
+
+  inline uint8_t qsub8(uint8_t i, uint8_t j)
+  {
+    asm volatile(
+      "sub  %0, %1"           "\n\t"
+      "brcc 1f"               "\n\t"
+      "ldi  %0, 0x00"         "\n\t"
+      "1:"                    "\n\t"
+      : "+a" (i)
+      : "a" (j)
+    );
+    return i;
+  }
+
+#else
+
+  constexpr uint8_t scale8(uint8_t i, uint8_t scale)
+  {
+    return (uint8_t)((i * (scale + 1u)) >> 8);
+  }
+
+  // never turns a lit channel off, keeps dim colors from dropping out
+  constexpr uint8_t scale8_video(uint8_t i, uint8_t scale)
+  {
+    return (uint8_t)(((i * scale) >> 8) + (i && scale ? 1u : 0u));
+  }
+
+  constexpr uint8_t qadd8(uint8_t i, uint8_t j)
+  {
+    return i + j > 255 ? 255u : (uint8_t)(i + j);
+  }
+
+  constexpr uint8_t qsub8(uint8_t i, uint8_t j)
+  {
+    return i > j ? (uint8_t)(i - j) : 0u;
+  }
+
+#endif
+
+  // a at frac 0, b at frac 255
+  inline uint8_t lerp8(uint8_t a, uint8_t b, uint8_t frac)
+  {
+    return b > a ? a + scale8(b - a, frac) : a - scale8(a - b, frac);
+  }
+
+  inline LED scale8(const LED& led, uint8_t scale)
+  {
+    return LED(scale8(led.r, scale), scale8(led.g, scale), scale8(led.b, scale));
+  }
+
+  inline LED blend(const LED& a, const LED& b, uint8_t amount)
+  {
+    return LED(lerp8(a.r, b.r, amount), lerp8(a.g, b.g, amount), lerp8(a.b, b.b, amount));
+  }
+
+  // 128 + 127 * sin(2 pi theta / 256)
+  inline uint8_t sin8(uint8_t theta)
+  {
+    uint8_t i = theta & 63u;
+    uint8_t v = pgm_read_byte(&__SIN8_QUARTER[theta & 64u ? 64u - i : i]);
+    return theta & 128u ? 128u - v : 128u + v;
+  }
+
+  inline uint8_t cos8(uint8_t theta)
+  {
+    return sin8(theta + 64u);
+  }
+
+  // one generator shared by every translation unit
+  inline uint16_t& random16State()
+  {
+    static uint16_t state = 0xACE1u;
+    return state;
+  }
+
+  inline void random16Seed(uint16_t seed)
+  {
+    random16State() = seed ? seed : 0xACE1u;
+  }
+
+  // xorshift, period 65535
+  inline uint16_t random16()
+  {
+    uint16_t& state = random16State();
+    uint16_t x = state;
+    x ^= x << 7;
+    x ^= x >> 9;
+    x ^= x << 8;
+    return state = x;
+  }
+
+  // 0 - lim-1
+  inline uint16_t random16(uint16_t lim)
+  {
+    return ((uint32_t)random16() * lim) >> 16;
+  }
+
+  inline uint8_t random8()
+  {
+    return random16() >> 8;
+  }
+
+  // 0 - lim-1
+  inline uint8_t random8(uint8_t lim)
+  {
+    return (random8() * lim) >> 8;
+  }
+
+  // min - lim-1
+  inline uint8_t random8(uint8_t min, uint8_t lim)
+  {
+    return min + random8(lim - min);
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "timing.hpp"
+
+/**
+ * WS2812B bit encoding for the ESP32 RMT peripheral. Only the item format and the tick math
+ * live here, without the driver, so they build and are tested on the host as well.
+ */
+
+// RMT is clocked from APB (80 MHz) independently of F_CPU, 2 -> 25 ns per tick
+#define WS2812B_RMT_CLK_DIV 2
+#define WS2812B_RMT_APB_HZ 80000000ul
+
+// transmit channels, one per pin; begin() fails for pins past them. Include <driver/rmt.h> first
+#ifdef SOC_RMT_TX_CANDIDATES_PER_GROUP
+#define WS2812B_RMT_CHANNELS SOC_RMT_TX_CANDIDATES_PER_GROUP
+#else
+#define WS2812B_RMT_CHANNELS RMT_CHANNEL_MAX
+#endif
+
+// the encoder runs in the RMT interrupt, on ESP32 it has to be in IRAM
+#ifdef IRAM_ATTR
+#define WS2812B_RMT_IRAM IRAM_ATTR
+#else
+#define WS2812B_RMT_IRAM
+#endif
+
+namespace WS2812B
+{
+  namespace rmt
+  {
+    constexpr uint32_t nsToTicks(uint32_t ns)
+    {
+      return (ns * (WS2812B_RMT_APB_HZ / WS2812B_RMT_CLK_DIV / 1000000ul) + 500ul) / 1000ul;
+    }
+
+    // duration0 | level0 | duration1 | level1 (rmt_item32_t layout)
+    constexpr uint32_t item(uint32_t high_ns, uint32_t low_ns)
+    {
+      return nsToTicks(high_ns) | (1ul << 15) | (nsToTicks(low_ns) << 16);
+    }
+
+    constexpr uint32_t BIT0 = item(timing::T0H, timing::T0L);
+    constexpr uint32_t BIT1 = item(timing::T1H, timing::T1L);
+
+    /**
+     * Encodes whole bytes, scaled by scale (256 - unchanged), while 8 more items fit in
+     * wanted_num. ITEM is rmt_item32_t or anything with a uint32_t val. Returns the number of
+     * bytes consumed, item_num gets the number of items written.
+     */
+    template <typename ITEM>
+    WS2812B_RMT_IRAM size_t encode(const uint8_t* src, size_t src_size, uint16_t scale, ITEM* dest, size_t wanted_num, size_t* item_num)
+    {
+      size_t size = 0, num = 0;
+      if (src && dest)
+      {
+        while (size < src_size && num + 8 <= wanted_num)
+        {
+          uint8_t b = (uint8_t)((src[size] * scale) >> 8);
+          for (uint8_t mask = 0x80; mask; mask >>= 1) (dest++)->val = (b & mask) ? BIT1 : BIT0;
+          ++size;
+          num += 8;
+        }
+      }
+      *item_num = num;
+      return size;
+    }
+  }
+}
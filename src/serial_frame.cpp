@@ -0,0 +1,381 @@
+#include "serial_frame.hpp"
+
+#define WS2812B_SERIAL_ADALIGHT 'A'
+#define WS2812B_SERIAL_RUN_MIN 4u // shortest run worth splitting a literal span
+#define WS2812B_SERIAL_SEGMENT_MAX 256u
+
+namespace WS2812B
+{
+  enum : uint8_t
+  {
+    SERIAL_WAIT,
+    SERIAL_MAGIC,
+    SERIAL_ADA_D,
+    SERIAL_ADA_A,
+    SERIAL_TYPE,
+    SERIAL_N_HI,
+    SERIAL_N_LO,
+    SERIAL_HEADER,
+    SERIAL_START_HI,
+    SERIAL_START_LO,
+    SERIAL_COUNT,
+    SERIAL_RGB,
+    SERIAL_SUM1,
+    SERIAL_SUM2
+  };
+
+  SerialReceiver::SerialReceiver(Strip* strip)
+  : strip{strip},
+    state{SERIAL_WAIT},
+    type{0u},
+    header{0u},
+    n{0u},
+    pos{0u},
+    seg{0u},
+    run{false},
+    synced{false},
+    rgb{0u, 0u, 0u},
+    rgb_i{0u},
+    sum1{0u},
+    sum2{0u},
+    shown{0u},
+    bad{0u},
+    skipped{0u}
+  {}
+
+  bool SerialReceiver::feed(uint8_t byte)
+  {
+    if (strip == nullptr) return false;
+
+    switch (state)
+    {
+    case SERIAL_WAIT:
+      if (byte == 'W') state = SERIAL_MAGIC;
+      else if (byte == 'A') state = SERIAL_ADA_D;
+      return false;
+    case SERIAL_MAGIC:
+      state = byte == 'S' ? SERIAL_TYPE : byte == 'W' ? SERIAL_MAGIC : SERIAL_WAIT;
+      return false;
+    case SERIAL_ADA_D:
+      state = byte == 'd' ? SERIAL_ADA_A : SERIAL_WAIT;
+      return false;
+    case SERIAL_ADA_A:
+      state = byte == 'a' ? SERIAL_N_HI : SERIAL_WAIT;
+      type = WS2812B_SERIAL_ADALIGHT;
+      header = 0u;
+      return false;
+    case SERIAL_TYPE:
+      if (byte != WS2812B_SERIAL_FULL && byte != WS2812B_SERIAL_RLE && byte != WS2812B_SERIAL_DELTA)
+      {
+        state = SERIAL_WAIT;
+        return false;
+      }
+      type = byte;
+      header = byte;
+      state = SERIAL_N_HI;
+      return false;
+    case SERIAL_N_HI:
+      n = byte << 8;
+      header ^= byte;
+      state = SERIAL_N_LO;
+      return false;
+    case SERIAL_N_LO:
+      n |= byte;
+      header ^= byte;
+      state = SERIAL_HEADER;
+      return false;
+    case SERIAL_HEADER:
+      if (byte != (header ^ 0x55))
+      {
+        state = SERIAL_WAIT;
+        return false;
+      }
+      pos = 0u;
+      rgb_i = 0u;
+      sum1 = sum2 = 0u;
+      run = false;
+      if (type == WS2812B_SERIAL_ADALIGHT || type == WS2812B_SERIAL_FULL)
+      {
+        seg = type == WS2812B_SERIAL_ADALIGHT ? n + 1u : n;
+        n = 0u;
+        state = seg ? SERIAL_RGB : SERIAL_SUM1;
+      }
+      else nextSegment();
+      return false;
+    case SERIAL_SUM1:
+      header = byte == sum1;
+      state = SERIAL_SUM2;
+      return false;
+    case SERIAL_SUM2:
+      state = SERIAL_WAIT;
+      return complete(header && byte == sum2);
+    }
+
+    // payload
+    sum1 += byte;
+    sum2 += sum1;
+    switch (state)
+    {
+    case SERIAL_START_HI:
+      pos = (byte & 0x7F) << 8;
+      run = byte & 0x80;
+      state = SERIAL_START_LO;
+      break;
+    case SERIAL_START_LO:
+      pos |= byte;
+      state = SERIAL_COUNT;
+      break;
+    case SERIAL_COUNT:
+      seg = byte + 1u;
+      state = SERIAL_RGB;
+      break;
+    case SERIAL_RGB:
+      rgb[rgb_i++] = byte;
+      if (rgb_i < 3u) break;
+      rgb_i = 0u;
+      put();
+      if (seg) break;
+      if (type == WS2812B_SERIAL_ADALIGHT)
+      {
+        state = SERIAL_WAIT;
+        return complete(true);
+      }
+      nextSegment();
+      break;
+    }
+    return false;
+  }
+
+  uint16_t SerialReceiver::feed(const uint8_t* data, uint16_t len)
+  {
+    if (data == nullptr) return 0u;
+    uint16_t frames = 0u;
+    for (uint16_t i = 0; i < len; ++i) frames += feed(data[i]);
+    return frames;
+  }
+
+  // writes the pixel in rgb once, or seg times for a run
+  void SerialReceiver::put()
+  {
+    uint16_t count = run ? seg : 1u;
+    seg -= count;
+    if (type != WS2812B_SERIAL_DELTA || synced)
+    {
+      if (count == 1u) strip->writePixelsRGB(pos, rgb, 1u);
+      else if (pos < strip->numPixels())
+      {
+        uint32_t last = (uint32_t)pos + count - 1u;
+        strip->fillFromTo(Color(rgb[0], rgb[1], rgb[2]), pos, last < strip->numPixels() ? last : strip->numPixels() - 1u);
+      }
+    }
+    pos += count;
+  }
+
+  void SerialReceiver::nextSegment()
+  {
+    if (type == WS2812B_SERIAL_FULL || n == 0u)
+    {
+      state = SERIAL_SUM1;
+      return;
+    }
+    --n;
+    run = type == WS2812B_SERIAL_RLE;
+    state = run ? SERIAL_COUNT : SERIAL_START_HI;
+  }
+
+  bool SerialReceiver::complete(bool ok)
+  {
+    if (!ok)
+    {
+      // the pixels are already in the buffer, don't leave a corrupt frame there
+      strip->clear();
+      ++bad;
+      synced = false;
+      return false;
+    }
+    if (type == WS2812B_SERIAL_DELTA && !synced)
+    {
+      ++skipped;
+      return false;
+    }
+    synced = true;
+    strip->show();
+    ++shown;
+    return true;
+  }
+
+  void SerialReceiver::reset()
+  {
+    state = SERIAL_WAIT;
+    synced = false;
+  }
+
+  uint32_t SerialReceiver::framesShown() const
+  {
+    return shown;
+  }
+
+  uint32_t SerialReceiver::framesBad() const
+  {
+    return bad;
+  }
+
+  uint32_t SerialReceiver::framesSkipped() const
+  {
+    return skipped;
+  }
+
+  void SerialReceiver::resetStats()
+  {
+    shown = 0u;
+    bad = 0u;
+    skipped = 0u;
+  }
+
+  namespace serial
+  {
+    struct Writer
+    {
+      uint8_t* out;
+      uint32_t size;
+      uint8_t sum1;
+      uint8_t sum2;
+
+      void byte(uint8_t b)
+      {
+        if (out) out[size] = b;
+        ++size;
+      }
+
+      void payload(uint8_t b)
+      {
+        byte(b);
+        sum1 += b;
+        sum2 += sum1;
+      }
+
+      void pixel(const LED& led)
+      {
+        payload(led.r);
+        payload(led.g);
+        payload(led.b);
+      }
+    };
+
+    static bool same(const LED& a, const LED& b)
+    {
+      return a.r == b.r && a.g == b.g && a.b == b.b;
+    }
+
+    static uint16_t runLength(const LED* leds, uint16_t from, uint16_t to)
+    {
+      uint16_t i = from + 1u;
+      while (i < to && (uint16_t)(i - from) < WS2812B_SERIAL_SEGMENT_MAX && same(leds[i], leds[from])) ++i;
+      return i - from;
+    }
+
+    // payload goes after the 6 header bytes, the header is written when n is known
+    static Writer start(uint8_t* out)
+    {
+      return Writer{out, 6u, 0u, 0u};
+    }
+
+    static uint32_t finish(Writer& w, uint8_t type, uint16_t n)
+    {
+      if (w.out)
+      {
+        w.out[0] = 'W';
+        w.out[1] = 'S';
+        w.out[2] = type;
+        w.out[3] = n >> 8;
+        w.out[4] = n;
+        w.out[5] = type ^ w.out[3] ^ w.out[4] ^ 0x55;
+      }
+      w.byte(w.sum1);
+      w.byte(w.sum2);
+      return w.size;
+    }
+
+    uint32_t encodeFull(const LED* leds, uint16_t len, uint8_t* out)
+    {
+      if (leds == nullptr) return 0u;
+      Writer w = start(out);
+      for (uint16_t i = 0; i < len; ++i) w.pixel(leds[i]);
+      return finish(w, WS2812B_SERIAL_FULL, len);
+    }
+
+    uint32_t encodeRLE(const LED* leds, uint16_t len, uint8_t* out)
+    {
+      if (leds == nullptr) return 0u;
+      Writer w = start(out);
+      uint16_t n = 0u;
+      for (uint16_t i = 0; i < len; ++n)
+      {
+        uint16_t r = runLength(leds, i, len);
+        w.payload(r - 1u);
+        w.pixel(leds[i]);
+        i += r;
+      }
+      return finish(w, WS2812B_SERIAL_RLE, n);
+    }
+
+    uint32_t encodeDelta(const LED* prev, const LED* leds, uint16_t len, uint8_t* out)
+    {
+      if (prev == nullptr || leds == nullptr || len > WS2812B_SERIAL_DELTA_MAX) return 0u;
+      Writer w = start(out);
+      uint16_t n = 0u;
+      uint16_t i = 0u;
+      while (i < len)
+      {
+        if (same(prev[i], leds[i]))
+        {
+          ++i;
+          continue;
+        }
+
+        // changed range, a single unchanged pixel is cheaper to resend than a new span header
+        uint16_t end = i + 1u;
+        while (end < len)
+        {
+          if (!same(prev[end], leds[end])) ++end;
+          else if (end + 1u < len && !same(prev[end + 1u], leds[end + 1u])) end += 2u;
+          else break;
+        }
+
+        while (i < end)
+        {
+          uint16_t r = runLength(leds, i, end);
+          uint16_t count = r;
+          bool is_run = r >= 2u;
+          if (!is_run)
+          {
+            // literal up to the next run worth its own span
+            count = 1u;
+            while (i + count < end && count < WS2812B_SERIAL_SEGMENT_MAX && runLength(leds, i + count, end) < WS2812B_SERIAL_RUN_MIN) ++count;
+          }
+          uint16_t first = i | (is_run ? WS2812B_SERIAL_RUN : 0u);
+          w.payload(first >> 8);
+          w.payload(first);
+          w.payload(count - 1u);
+          if (is_run) w.pixel(leds[i]);
+          else for (uint16_t k = 0; k < count; ++k) w.pixel(leds[i + k]);
+          i += count;
+          ++n;
+        }
+      }
+      return finish(w, WS2812B_SERIAL_DELTA, n);
+    }
+
+    uint32_t encode(const LED* prev, const LED* leds, uint16_t len, uint8_t* out)
+    {
+      if (leds == nullptr) return 0u;
+      uint32_t full = encodeFull(leds, len, nullptr);
+      uint32_t rle = encodeRLE(leds, len, nullptr);
+      uint32_t delta = encodeDelta(prev, leds, len, nullptr);
+
+      if (delta && delta < full && delta < rle) return encodeDelta(prev, leds, len, out);
+      if (rle < full) return encodeRLE(leds, len, out);
+      return encodeFull(leds, len, out);
+    }
+  }
+}
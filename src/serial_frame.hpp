@@ -0,0 +1,88 @@
+#pragma once
+#include "ws2812b.hpp"
+
+/**
+ * Frame protocol for UART / USB CDC links.
+ *
+ *   'W' 'S' type n_hi n_lo (type ^ n_hi ^ n_lo ^ 0x55) payload sum1 sum2
+ *
+ *   'F'  n pixels: r g b
+ *   'R'  n runs from LED 0: count - 1, r g b
+ *   'D'  n spans: start_hi start_lo count - 1, then count * r g b;
+ *        with bit 15 of start set a single r g b is repeated count times (LEDs 0 - 32767)
+ *
+ * sum1, sum2 - two running byte sums of the payload (sum1 += b, sum2 += sum1), both mod 256.
+ * Fletcher-style, but not Fletcher-16, which sums mod 255. Adalight frames
+ * ('A' 'd' 'a' n_hi n_lo n_hi ^ n_lo ^ 0x55, n + 1 pixels, no checksum) are accepted too.
+ *
+ * SerialReceiver decodes byte by byte straight into the strip buffer, nothing is staged, so
+ * the pixels of a frame are in the buffer before its checksum is known. A frame failing its
+ * checksum is not shown and the buffer is cleared, so the corrupt pixels can't be shown later
+ * (by strip.show() or a delta frame); delta frames are ignored until the next full or RLE frame,
+ * as their base is unknown then.
+ */
+
+#define WS2812B_SERIAL_FULL 'F'
+#define WS2812B_SERIAL_RLE 'R'
+#define WS2812B_SERIAL_DELTA 'D'
+#define WS2812B_SERIAL_RUN 0x8000u
+// LEDs a delta frame can address, the span start has 15 bits
+#define WS2812B_SERIAL_DELTA_MAX 32768u
+// sent by the sketch after a frame was shown, the strip output blocks the UART on AVR
+#define WS2812B_SERIAL_ACK 'K'
+
+namespace WS2812B
+{
+  class SerialReceiver
+  {
+  public:
+    SerialReceiver(Strip* strip);
+    // true when the byte completed a valid frame and the strip was shown
+    bool feed(uint8_t byte);
+    // returns the number of frames shown
+    uint16_t feed(const uint8_t* data, uint16_t len);
+    void reset();
+    uint32_t framesShown() const;
+    uint32_t framesBad() const; // checksum errors
+    uint32_t framesSkipped() const; // delta frames without a base frame
+    void resetStats();
+
+  private:
+    void put();
+    void nextSegment();
+    bool complete(bool ok);
+    Strip* strip;
+    uint8_t state;
+    uint8_t type;
+    uint8_t header;
+    uint16_t n; // pixels ('F', 'A') or segments left
+    uint16_t pos;
+    uint16_t seg; // pixels left in the segment
+    bool run;
+    bool synced; // buffer holds a complete frame, deltas can be applied
+    uint8_t rgb[3];
+    uint8_t rgb_i;
+    uint8_t sum1;
+    uint8_t sum2;
+    uint32_t shown;
+    uint32_t bad;
+    uint32_t skipped;
+  };
+
+  namespace serial
+  {
+    // largest frame encode() can return
+    constexpr uint32_t maxFrameSize(uint16_t len)
+    {
+      return 8u + 3u * (uint32_t)len;
+    }
+
+    // out == nullptr - only the size is returned
+    uint32_t encodeFull(const LED* leds, uint16_t len, uint8_t* out);
+    uint32_t encodeRLE(const LED* leds, uint16_t len, uint8_t* out);
+    // 0 - len above WS2812B_SERIAL_DELTA_MAX, not encodable as a delta frame
+    uint32_t encodeDelta(const LED* prev, const LED* leds, uint16_t len, uint8_t* out);
+    // smallest encoding of the frame, prev == nullptr or len above WS2812B_SERIAL_DELTA_MAX - full or RLE
+    uint32_t encode(const LED* prev, const LED* leds, uint16_t len, uint8_t* out);
+  }
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * Compile time cycle budgets for bit-banged WS2812B output.
+ *
+ * A transmit loop is described by the cycles it spends between its three port stores
+ * without any padding:
+ *   HI_TO_DATA  from the store setting the pin high to the store of the bit value
+ *   DATA_TO_LO  from the bit value store to the store setting the pin low
+ *   LO_TO_HI    from the low store to the high store of the next bit
+ *   BYTE_GAP    extra cycles in the low phase of the last bit of a byte (loading the next one)
+ * BitLoop adds nop padding to each of them to hit the nominal timings at the given clock
+ * and reports whether the result stays in the datasheet windows.
+ *
+ * t0h = 250ns - 550ns   (nominal 400ns)
+ * t1h = 650ns - 950ns   (nominal 800ns)
+ * t0l = 700ns - 5000ns  (nominal 850ns)
+ * t1l = 300ns - 5000ns  (nominal 450ns)
+ *
+ * The datasheet limits the low phases to 1000/600ns, but the chips decode a bit from its high
+ * time only and take a low phase as reset far above 5us, so a longer low only slows the frame.
+ * Below 20 MHz the fixed cycles of the loops are longer than the nominal 1.25us bit: the serial
+ * loop sends a bit in 22 cycles at 16 MHz (1.375us, ~727 kbit/s) and 15 cycles at 8 MHz
+ * (1.875us, ~533 kbit/s). The timing is valid, the frame just takes longer.
+ */
+
+namespace WS2812B
+{
+  namespace timing
+  {
+    constexpr uint32_t T0H_MIN = 250u;
+    constexpr uint32_t T0H_MAX = 550u;
+    constexpr uint32_t T1H_MIN = 650u;
+    constexpr uint32_t T1H_MAX = 950u;
+    constexpr uint32_t T0L_MIN = 700u;
+    constexpr uint32_t T1L_MIN = 300u;
+    constexpr uint32_t TL_MAX = 5000u;
+
+    constexpr uint32_t T0H = 400u;
+    constexpr uint32_t T1H = 800u;
+    constexpr uint32_t T0L = 850u;
+    constexpr uint32_t T1L = 450u;
+
+    // nearest number of cycles
+    constexpr uint32_t cycles(uint32_t ns, uint32_t f_cpu)
+    {
+      return (uint32_t)(((uint64_t)ns * f_cpu + 500000000ull) / 1000000000ull);
+    }
+
+    constexpr uint32_t nanos(uint32_t cycles, uint32_t f_cpu)
+    {
+      return (uint32_t)((uint64_t)cycles * 1000000000ull / f_cpu);
+    }
+
+    constexpr uint32_t pad(uint32_t target, uint32_t fixed)
+    {
+      return target > fixed ? target - fixed : 0u;
+    }
+
+    constexpr bool within(uint32_t ns, uint32_t min, uint32_t max)
+    {
+      return ns >= min && ns <= max;
+    }
+
+    template <uint32_t F_CPU_HZ, uint8_t HI_TO_DATA, uint8_t DATA_TO_LO, uint8_t LO_TO_HI, uint8_t BYTE_GAP = 0>
+    struct BitLoop
+    {
+      static constexpr uint8_t d1 = (uint8_t)pad(cycles(T0H, F_CPU_HZ), HI_TO_DATA);
+      static constexpr uint8_t d2 = (uint8_t)pad(cycles(T1H, F_CPU_HZ), HI_TO_DATA + d1 + DATA_TO_LO);
+      static constexpr uint8_t d3 = (uint8_t)pad(cycles(T1L, F_CPU_HZ), LO_TO_HI);
+
+      static constexpr uint8_t t0h = HI_TO_DATA + d1;
+      static constexpr uint8_t t1h = t0h + DATA_TO_LO + d2;
+      static constexpr uint8_t period = t1h + LO_TO_HI + d3;
+      static constexpr uint8_t t0l = period - t0h;
+      static constexpr uint8_t t1l = period - t1h;
+      static constexpr uint8_t gap = BYTE_GAP;
+
+      static constexpr bool t0h_ok = within(nanos(t0h, F_CPU_HZ), T0H_MIN, T0H_MAX);
+      static constexpr bool t1h_ok = within(nanos(t1h, F_CPU_HZ), T1H_MIN, T1H_MAX);
+      static constexpr bool t0l_ok = within(nanos(t0l, F_CPU_HZ), T0L_MIN, TL_MAX);
+      static constexpr bool t1l_ok = within(nanos(t1l, F_CPU_HZ), T1L_MIN, TL_MAX);
+      static constexpr bool gap_ok = nanos(t0l + BYTE_GAP, F_CPU_HZ) <= TL_MAX;
+      static constexpr bool ok = t0h_ok && t1h_ok && t0l_ok && t1l_ok && gap_ok;
+    };
+
+    /**
+     * Loops of the AVR backend (atmega.cpp, atmega.hpp), the host recorder replays the same
+     * cycle counts, so its waveform is the one the AVR sends at that clock.
+     *   Serial     st, 9 cycles low; byte gap: sbiw, breq, ld, mul, mov, clr, mov, sbrc + mov, ldi, rjmp - brne
+     *   SerialRaw  the same without brightness scaling (mul, mov, clr)
+     *   Static     out instead of st
+     *   Parallel   st, 9 cycles low (ld, or, sbiw, brne) over a staged frame, no byte gap
+     */
+    template <uint32_t F_CPU_HZ>
+    using SerialLoop = BitLoop<F_CPU_HZ, 2, 2, 9, 14>;
+
+    template <uint32_t F_CPU_HZ>
+    using SerialRawLoop = BitLoop<F_CPU_HZ, 2, 2, 9, 10>;
+
+    template <uint32_t F_CPU_HZ>
+    using StaticLoop = BitLoop<F_CPU_HZ, 1, 1, 8, 14>;
+
+    template <uint32_t F_CPU_HZ>
+    using ParallelLoop = BitLoop<F_CPU_HZ, 2, 2, 9>;
+  }
+}
@@ -1,4 +1,5 @@
 #include "ws2812b.hpp"
+#include "math8.hpp"
 
 // ########################################### WS2812B #################################################################
 
@@ -67,7 +68,7 @@ namespace WS2812B
     {
       pinMode(pin, OUTPUT);
       digitalWrite(pin, LOW);
-      return 1;
+      return _extern_begin(pin);
     }
     return 0;
   }
@@ -90,714 +91,2370 @@ namespace WS2812B
     return color;
   }
 
-  void fill(LED* leds, uint16_t len, uint32_t color)
+  // all fills go through one kernel, the color is expanded once to the GRB byte pattern
+  static void fillKernel(LED* leds, uint16_t len, uint8_t r, uint8_t g, uint8_t b)
   {
-    if (leds == nullptr) return;
-    for (uint16_t i = 0; i < len; ++i) leds[i] = color;
+    if (leds == nullptr || len == 0) return;
+    uint8_t* p = (uint8_t*)leds;
+#ifdef AVR
+    // 4 pixels per iteration
+    for (uint16_t n = len >> 2; n; --n)
+    {
+      *p++ = g; *p++ = r; *p++ = b;
+      *p++ = g; *p++ = r; *p++ = b;
+      *p++ = g; *p++ = r; *p++ = b;
+      *p++ = g; *p++ = r; *p++ = b;
+    }
+    for (len &= 3; len; --len)
+    {
+      *p++ = g; *p++ = r; *p++ = b;
+    }
+#else
+    // 12 byte (4 pixel) pattern, then memcpy doubling which runs on word stores
+    uint16_t first = len < 4 ? len : 4;
+    for (uint16_t i = 0; i < first; ++i, p += 3) p[0] = g, p[1] = r, p[2] = b;
+    p = (uint8_t*)leds;
+    size_t done = first * 3u;
+    size_t total = len * 3u;
+    while (done < total)
+    {
+      size_t chunk = done < total - done ? done : total - done;
+      memcpy(p + done, p, chunk);
+      done += chunk;
+    }
+#endif
   }
 
-  void fill(LED* leds, uint16_t len, const Color& color)
+  // same doubling as fillKernel for pixels of any size (RGBW, other color orders)
+  void fillBytes(void* dst, uint16_t count, const void* pixel, uint8_t size)
   {
-    if (leds == nullptr) return;
-    for (uint16_t i = 0; i < len; ++i) leds[i] = color;
+    if (dst == nullptr || count == 0 || size == 0) return;
+    uint8_t* p = (uint8_t*)dst;
+    memcpy(p, pixel, size);
+    size_t done = size;
+    size_t total = (size_t)count * size;
+    while (done < total)
+    {
+      size_t chunk = done < total - done ? done : total - done;
+      memcpy(p + done, p, chunk);
+      done += chunk;
+    }
   }
 
-  void fill(LED* leds, uint16_t len, uint8_t r, uint8_t g, uint8_t b)
+#define WS2812B_ORDER(O) {Layout<O>::r, Layout<O>::g, Layout<O>::b, Layout<O>::size}
+  // r, g, b byte offsets and pixel size of every ColorOrder
+  static const uint8_t __ORDERS[8][4] PROGMEM = {
+    WS2812B_ORDER(GRB), WS2812B_ORDER(RGB), WS2812B_ORDER(BRG), WS2812B_ORDER(RBG),
+    WS2812B_ORDER(GBR), WS2812B_ORDER(BGR), WS2812B_ORDER(GRBW), WS2812B_ORDER(RGBW)
+  };
+#undef WS2812B_ORDER
+
+  // dst moves by step (1 or -1 for reversed strips), src forward
+  static void copyPixels(LED* dst, int8_t step, const LED* src, uint16_t n)
   {
-    if (leds == nullptr) return;
-    for (uint16_t i = 0; i < len; ++i) leds[i].r = r, leds[i].g = g, leds[i].b = b;
+    if (step > 0) return (void)memcpy((uint8_t*)dst, src, n * 3);
+    for (; n; --n, --dst, ++src) *dst = *src;
   }
 
-  void fillFromTo(LED* leds, uint16_t len, uint32_t color, uint16_t from, uint16_t to)
+  static void copyPixelsRGB(LED* dst, int8_t step, const uint8_t* src, uint16_t n, ColorOrder order)
   {
-    if (leds == nullptr || from > to || to >= len) return;
-    for (uint16_t i = from; i <= to; ++i) leds[i] = color;
+    if (order == GRB) return copyPixels(dst, step, (const LED*)src, n);
+    uint8_t r = pgm_read_byte(&__ORDERS[order][0]);
+    uint8_t g = pgm_read_byte(&__ORDERS[order][1]);
+    uint8_t b = pgm_read_byte(&__ORDERS[order][2]);
+    if (pgm_read_byte(&__ORDERS[order][3]) == 3u)
+    {
+      for (; n; --n, dst += step, src += 3)
+      {
+        dst->r = src[r];
+        dst->g = src[g];
+        dst->b = src[b];
+      }
+      return;
+    }
+    for (; n; --n, dst += step, src += 4)
+    {
+      dst->r = qadd8(src[r], src[3]);
+      dst->g = qadd8(src[g], src[3]);
+      dst->b = qadd8(src[b], src[3]);
+    }
   }
 
-  void fillFromTo(LED* leds, uint16_t len, const Color& color, uint16_t from, uint16_t to)
+  static void readPixels(LED* dst, const LED* src, int8_t step, uint16_t n)
   {
-    if (leds == nullptr || from > to || to >= len) return;
-    for (uint16_t i = from; i <= to; ++i) leds[i] = color;
+    if (step > 0) return (void)memcpy((uint8_t*)dst, src, n * 3);
+    for (; n; --n, ++dst, --src) *dst = *src;
   }
 
-  void fillFromTo(LED* leds, uint16_t len, uint8_t r, uint8_t g, uint8_t b, uint16_t from, uint16_t to)
+  void fill(LED* leds, uint16_t len, uint32_t color)
   {
-    if (leds == nullptr || from > to || to >= len) return;
-    for (uint16_t i = from; i <= to; ++i) leds[i].r = r, leds[i].g = g, leds[i].b = b;
+    fillKernel(leds, len, (uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color);
   }
 
-  void clear(LED* leds, uint16_t len)
+  void fill(LED* leds, uint16_t len, const Color& color)
   {
-    if (leds == nullptr) return;
-    memset((uint8_t*)leds, 0, len * 3);
+    fillKernel(leds, len, color.r, color.g, color.b);
   }
 
-  Color hsv(uint16_t hue, uint8_t sat, uint8_t val)
+  void fill(LED* leds, uint16_t len, uint8_t r, uint8_t g, uint8_t b)
   {
-    Color rgb;
-    hue = (hue * 1530L + 32768) / 65536L;
-
-    if (hue < 510) { // Red to Green-1
-      rgb.b = 0;          // b
-      if (hue < 255) { //   Red to Yellow-1
-        rgb.r = 255;        // r
-        rgb.g = hue;       //     g = 0 to 254
-      } else {         //   Yellow to Green-1
-        rgb.r = 510 - hue; //     r = 255 to 1
-        rgb.g = 255;        // g
-      }
-    } else if (hue < 1020) { // Green to Blue-1
-      rgb.r = 0;            // r
-      if (hue < 765) { //   Green to Cyan-1
-        rgb.g = 255;        // g
-        rgb.b = hue - 510;  //     b = 0 to 254
-      } else {          //   Cyan to Blue-1
-        rgb.g = 1020 - hue; //     g = 255 to 1
-        rgb.b = 255;        // b
-      }
-    } else if (hue < 1530) { // Blue to Red-1
-      rgb.g = 0;            // g
-      if (hue < 1275) { //   Blue to Magenta-1
-        rgb.r = hue - 1020; //     r = 0 to 254
-        rgb.b = 255;        // b
-      } else { //   Magenta to Red-1
-        rgb.r = 255;        // r
-        rgb.b = 1530 - hue; //     b = 255 to 1
-      }
-    } else { // Last 0.5 Red (quicker than % operator)
-      rgb.r = 255;        // r
-      rgb.g = rgb.b = 0;      // g = b = 0
-    }
+    fillKernel(leds, len, r, g, b);
+  }
 
-    // Apply saturation and value to R,G,B, pack into 32-bit result:
-    uint32_t v1 = 1 + val;  // 1 to 256; allows >>8 instead of /255
-    uint16_t s1 = 1 + sat;  // 1 to 256; same reason
-    uint8_t s2 = 255 - sat; // 255 to 0
-    
-    rgb.r = (((rgb.r * s1) >> 8) + s2) * v1 >> 8;
-    rgb.g = (((rgb.g * s1) >> 8) + s2) * v1 >> 8;
-    rgb.b = (((rgb.b * s1) >> 8) + s2) * v1 >> 8;
+  void fillFromTo(LED* leds, uint16_t len, uint32_t color, uint16_t from, uint16_t to)
+  {
+    if (leds == nullptr || from > to || to >= len) return;
+    fillKernel(leds + from, to - from + 1, (uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color);
+  }
 
-    return rgb;
+  void fillFromTo(LED* leds, uint16_t len, const Color& color, uint16_t from, uint16_t to)
+  {
+    if (leds == nullptr || from > to || to >= len) return;
+    fillKernel(leds + from, to - from + 1, color.r, color.g, color.b);
   }
 
-}
+  void fillFromTo(LED* leds, uint16_t len, uint8_t r, uint8_t g, uint8_t b, uint16_t from, uint16_t to)
+  {
+    if (leds == nullptr || from > to || to >= len) return;
+    fillKernel(leds + from, to - from + 1, r, g, b);
+  }
 
-// ############################################################################################################################
+  const uint32_t PALETTE_RAINBOW[16] PROGMEM = {
+    0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00, 0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+    0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5, 0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B
+  };
 
-static  WS2812B::LED void_led{0};
+  const uint32_t PALETTE_PARTY[16] PROGMEM = {
+    0x5500AB, 0x84007C, 0xB5004B, 0xE5001B, 0xE81700, 0xB84700, 0xAB7700, 0xABAB00,
+    0xAB5500, 0xDD2200, 0xF2000E, 0xC2003E, 0x8F0071, 0x5F00A1, 0x2F00D0, 0x0007F9
+  };
 
-// ########################################### WS2812B_STRIP ##################################################################
+  const uint32_t PALETTE_HEAT[16] PROGMEM = {
+    0x000000, 0x330000, 0x660000, 0x990000, 0xCC0000, 0xFF0000, 0xFF3300, 0xFF6600,
+    0xFF9900, 0xFFCC00, 0xFFFF00, 0xFFFF33, 0xFFFF66, 0xFFFF99, 0xFFFFCC, 0xFFFFFF
+  };
 
+  const uint32_t PALETTE_LAVA[16] PROGMEM = {
+    0x000000, 0x800000, 0x000000, 0x800000, 0x8B0000, 0x800000, 0x8B0000, 0x8B0000,
+    0x8B0000, 0xFF0000, 0xFFA500, 0xFFFFFF, 0xFFA500, 0xFF0000, 0x8B0000, 0x000000
+  };
 
-namespace WS2812B
-{
-  extern void _extern_timer_show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright, uint32_t& timer);
+  const uint32_t PALETTE_OCEAN[16] PROGMEM = {
+    0x191970, 0x00008B, 0x191970, 0x000080, 0x00008B, 0x0000CD, 0x2E8B57, 0x008080,
+    0x5F9EA0, 0x0000FF, 0x008B8B, 0x6495ED, 0x7FFFD4, 0x2E8B57, 0x00FFFF, 0x87CEFA
+  };
 
-  Strip::Strip(LED* leds, uint16_t len, uint8_t pin, bool reverse) 
-  : is_begin{0}, 
-    leds{leds}, 
-    count{len}, 
-    pin{pin}, 
-    reverse{reverse}, 
-    timer{0}, 
-    bright{255} 
-  {}
+  const uint32_t PALETTE_FOREST[16] PROGMEM = {
+    0x006400, 0x006400, 0x556B2F, 0x006400, 0x008000, 0x228B22, 0x6B8E23, 0x008000,
+    0x2E8B57, 0x66CDAA, 0x32CD32, 0x9ACD32, 0x90EE90, 0x7CFC00, 0x66CDAA, 0x228B22
+  };
 
-  Strip::Strip() : Strip(nullptr, 0u, 255u, 0) {}
+  Palette16::Palette16() : entries{} {}
 
-  bool Strip::begin()
+  void Palette16::load_P(const uint32_t* palette)
   {
-    is_begin = WS2812B::begin(pin);
-    return is_begin;
+    if (palette == nullptr) return;
+    for (uint8_t i = 0; i < 16; ++i) entries[i] = pgm_read_dword(&palette[i]);
   }
 
-  void Strip::setPin(uint8_t p)
+  // every channel moves at most step toward the target, false once the palettes are equal
+  bool Palette16::fadeToward(const Palette16& target, uint8_t step)
   {
-    pin = p;
-    begin();
+    bool changed = false;
+    uint8_t* c = (uint8_t*)entries;
+    const uint8_t* t = (const uint8_t*)target.entries;
+    for (uint8_t i = 0; i < 48; ++i)
+    {
+      if (c[i] == t[i]) continue;
+      changed = true;
+      if (c[i] < t[i]) c[i] = t[i] - c[i] > step ? c[i] + step : t[i];
+      else c[i] = c[i] - t[i] > step ? c[i] - step : t[i];
+    }
+    return changed;
   }
 
-  uint8_t Strip::getPin() const
+  bool Palette16::fadeToward_P(const uint32_t* palette, uint8_t step)
   {
-    return pin;
+    if (palette == nullptr) return false;
+    Palette16 target;
+    target.load_P(palette);
+    return fadeToward(target, step);
   }
 
-  void Strip::changeLEDsConfig(LED* _leds, uint16_t len)
+  // frac in 1/16 steps toward the next entry
+  static uint8_t paletteMix(uint8_t a, uint8_t b, uint8_t frac, uint8_t bright)
   {
-    leds = _leds;
-    count = len;
+    return scale8(lerp8(a, b, frac << 4), bright);
   }
 
-  LED& Strip::operator[](uint16_t led)
+  Color Palette16::get(uint8_t index, uint8_t bright, bool blend) const
   {
-    if (leds == nullptr || led >= count) return void_led;
-    if (reverse) return leds[count - 1 - led];
-    return leds[led];
-  } 
+    const LED& a = entries[index >> 4];
+    const LED& b = entries[((index >> 4) + 1) & 15];
+    uint8_t frac = blend ? index & 15 : 0;
+    return Color(paletteMix(a.r, b.r, frac, bright), paletteMix(a.g, b.g, frac, bright), paletteMix(a.b, b.b, frac, bright));
+  }
 
-  uint16_t Strip::numPixels() const
+  Color colorFromPalette_P(const uint32_t* palette, uint8_t index, uint8_t bright, bool blend)
   {
-    return count;
+    if (palette == nullptr) return Color{0u};
+    Palette16 p;
+    p.entries[index >> 4] = pgm_read_dword(&palette[index >> 4]);
+    p.entries[((index >> 4) + 1) & 15] = pgm_read_dword(&palette[((index >> 4) + 1) & 15]);
+    return p.get(index, bright, blend);
   }
 
-  bool Strip::isReverse() const
+  void fillFromPalette(LED* leds, uint16_t len, const Palette16& palette, uint8_t start_index, uint8_t step, uint8_t bright, bool blend)
   {
-    return reverse;
+    if (leds == nullptr) return;
+    uint8_t index = start_index;
+    for (uint16_t i = 0; i < len; ++i, index += step) leds[i] = palette.get(index, bright, blend);
   }
 
-  void Strip::setReverse(bool r)
+  // the palette is read from flash once per call, not once per LED
+  void fillFromPalette_P(LED* leds, uint16_t len, const uint32_t* palette, uint8_t start_index, uint8_t step, uint8_t bright, bool blend)
   {
-    reverse = r;
+    if (leds == nullptr || palette == nullptr) return;
+    Palette16 p;
+    p.load_P(palette);
+    fillFromPalette(leds, len, p, start_index, step, bright, blend);
   }
 
-  void Strip::fill(uint32_t color)
+  Layer::Layer(const LED* leds, uint16_t len, uint16_t offset, BlendMode mode, uint8_t alpha) : leds{leds}, len{len}, offset{offset}, mode{mode}, alpha{alpha} {}
+
+  Layer::Layer() : Layer(nullptr, 0u) {}
+
+  // the mode is a template parameter so every span loop has no switch inside
+  template <uint8_t MODE>
+  static inline uint8_t blendChannel(uint8_t d, uint8_t s, uint8_t alpha)
   {
-    WS2812B::fill(leds, count, color);
+    uint8_t f;
+    switch (MODE)
+    {
+    case BLEND_ADD:
+      return qadd8(d, scale8(s, alpha));
+    case BLEND_MULTIPLY:
+      f = scale8(d, s);
+      break;
+    case BLEND_SCREEN:
+      f = 255 - scale8(255 - d, 255 - s);
+      break;
+    case BLEND_MAX:
+      f = d > s ? d : s;
+      break;
+    default:
+      f = s;
+      break;
+    }
+    return lerp8(d, f, alpha);
   }
 
-  void Strip::fillFromTo(uint32_t color, uint16_t from, uint16_t to)
+  template <uint8_t MODE>
+  static void blendSpan(uint8_t* d, int8_t d_step, const uint8_t* s, uint16_t n, uint8_t a)
   {
-    if (!reverse) return WS2812B::fillFromTo(leds, count, color, from, to);
-    if (from > to || to >= count) return;
-    for (uint16_t i = count - 1 - from - to; i < count - from; ++i) leds[i] = color;
+    for (; n; --n, d += d_step, s += 3)
+    {
+      d[0] = blendChannel<MODE>(d[0], s[0], a);
+      d[1] = blendChannel<MODE>(d[1], s[1], a);
+      d[2] = blendChannel<MODE>(d[2], s[2], a);
+    }
   }
 
-  void Strip::fill(uint8_t r, uint8_t g, uint8_t b)
+  static void compositeSpan(uint8_t* d, int8_t d_step, const Layer& layer, uint16_t from, uint16_t n)
   {
-    WS2812B::fill(leds, count, r, g, b);
+    const uint8_t* s = (const uint8_t*)(layer.leds + (from - layer.offset));
+    uint8_t a = layer.alpha;
+    switch (layer.mode)
+    {
+    case BLEND_ADD: return blendSpan<BLEND_ADD>(d, d_step, s, n, a);
+    case BLEND_MULTIPLY: return blendSpan<BLEND_MULTIPLY>(d, d_step, s, n, a);
+    case BLEND_SCREEN: return blendSpan<BLEND_SCREEN>(d, d_step, s, n, a);
+    case BLEND_MAX: return blendSpan<BLEND_MAX>(d, d_step, s, n, a);
+    default: return blendSpan<BLEND_ALPHA>(d, d_step, s, n, a);
+    }
   }
 
-  void Strip::fillFromTo(uint8_t r, uint8_t g, uint8_t b, uint16_t from, uint16_t to)
+  // reverse walks the target from its end, layer offsets stay logical
+  static void compositeInto(LED* leds, uint16_t len, const Layer* layers, uint8_t count, bool reverse)
   {
-    if (!reverse) return WS2812B::fillFromTo(leds, count, r, g, b, from, to);
-    if (from > to || to >= count) return;
-    for (uint16_t i = count - 1 - from - to; i < count - from; ++i) leds[i].r = r, leds[i].g = g, leds[i].b = b;
+    if (leds == nullptr || layers == nullptr) return;
+    for (uint32_t block = 0; block < len; block += WS2812B_COMPOSITE_BLOCK)
+    {
+      uint32_t block_end = block + WS2812B_COMPOSITE_BLOCK < len ? block + WS2812B_COMPOSITE_BLOCK : len;
+      for (uint8_t k = 0; k < count; ++k)
+      {
+        const Layer& l = layers[k];
+        if (l.leds == nullptr || l.alpha == 0) continue;
+        uint32_t from = block > l.offset ? block : l.offset;
+        uint32_t to = block_end < (uint32_t)l.offset + l.len ? block_end : (uint32_t)l.offset + l.len;
+        if (from >= to) continue;
+        if (reverse) compositeSpan((uint8_t*)(leds + (len - 1 - from)), -3, l, from, to - from);
+        else compositeSpan((uint8_t*)(leds + from), 3, l, from, to - from);
+      }
+    }
   }
 
-  void Strip::fillFromTo(const Color& color, uint16_t from, uint16_t to)
+  void composite(LED* leds, uint16_t len, const Layer* layers, uint8_t count)
   {
-    if (!reverse) return WS2812B::fillFromTo(leds, count, color, from, to);
-    if (from > to || to >= count) return;
-    for (uint16_t i = count - 1 - from - to; i < count - from; ++i) leds[i] = color;
+    compositeInto(leds, len, layers, count, false);
   }
 
-  void Strip::fill(const Color& color)
+  void clear(LED* leds, uint16_t len)
   {
-    WS2812B::fill(leds, count, color);
+    if (leds == nullptr) return;
+    memset((uint8_t*)leds, 0, len * 3);
   }
 
-  void Strip::clear()
+  /**
+   * Hue is split into 6 sectors of 255 steps (1530 steps like before). In every sector one channel
+   * is 0, one is full and one rises or falls with the position, the table holds these roles
+   * (2 bits per channel, r g b from the lowest bits): 0 - zero, 1 - full, 2 - rising, 3 - falling.
+   * Sector 6 is the last half step of red.
+   */
+  static const uint8_t __HSV_SECTORS[7] PROGMEM = {0x09, 0x07, 0x24, 0x1C, 0x12, 0x31, 0x01};
+
+  HSVScale::HSVScale(uint8_t sat, uint8_t val) : sat{sat}, val{val}
   {
-    WS2812B::clear(leds, count);
+    lo = apply(0u);
+    hi = apply(255u);
   }
 
-  void Strip::show()
+  uint8_t HSVScale::apply(uint8_t c) const
   {
-    if (is_begin) WS2812B::_extern_timer_show(leds, count, pin, bright, timer);
+    return scale8(scale8(c, sat) + (255u - sat), val);
   }
 
-  uint8_t Strip::getBrightness() const
+  static Color hsvSector(uint8_t sector, uint8_t pos, const HSVScale& scale)
   {
-    return bright;
+    uint8_t v[4];
+    v[0] = scale.lo;
+    v[1] = scale.hi;
+    v[2] = scale.apply(pos);
+    v[3] = scale.apply(255 - pos);
+    uint8_t roles = pgm_read_byte(&__HSV_SECTORS[sector]);
+    return Color(v[roles & 3], v[(roles >> 2) & 3], v[roles >> 4]);
   }
 
-  Color Strip::getPixelColor(uint16_t n) const
+  Color hsv(uint16_t hue, uint8_t sat, uint8_t val)
   {
-    if (n >= count) return 0;
-    return leds[n];
+    uint16_t h = (hue * 1530UL + 32768) >> 16;
+    uint8_t sector = ((h + 1) * 257UL) >> 16; // h / 255 for h <= 1530
+    return hsvSector(sector, h - sector * 255, HSVScale(sat, val));
   }
 
-  void Strip::setBrightness(uint8_t b)
+  // position is kept as sector + 8.8 fixed point steps inside the sector (0 - 255 * 256)
+#define WS2812B_HSV_SECTOR_SIZE 65280u
+
+  HSVStepper::HSVStepper(uint16_t hue, int16_t step, uint8_t sat, uint8_t val) : sector{0}, pos{0u}, step_sectors{0}, step_pos{0u}, scale{sat, val}
   {
-    bright = b;
+    setHue(hue);
+    setStep(step);
   }
 
-  void Strip::setPixelColor(uint16_t n, uint32_t color)
+  void HSVStepper::setHue(uint16_t hue)
   {
-    if (n >= count) return;
-    leds[n] = color;
+    uint32_t p = (hue * 1530UL + 128) >> 8;
+    sector = p / WS2812B_HSV_SECTOR_SIZE;
+    pos = p - sector * WS2812B_HSV_SECTOR_SIZE;
   }
 
-  void Strip::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+  // negative steps walk forward by the complement, the hue circle wraps anyway
+  void HSVStepper::setStep(int16_t step)
   {
-    if (n >= count) return;
-    leds[n].r = r; leds[n].g = g; leds[n].b = b;
+    uint32_t p = ((uint16_t)step * 1530UL + 128) >> 8;
+    step_sectors = p / WS2812B_HSV_SECTOR_SIZE;
+    step_pos = p - step_sectors * WS2812B_HSV_SECTOR_SIZE;
   }
 
-  void Strip::setPixelColor(uint16_t n, Color color)
+  // the scale is rebuilt only here, not on every next()
+  void HSVStepper::setSaturation(uint8_t sat)
   {
-    if (n >= count) return;
-    leds[n] = color;
+    scale = HSVScale(sat, scale.val);
   }
 
-}
-
-// #############################################################################################################################
-
-
-
-// ############################################ WS2812B_STRIP_GROUP ############################################################
-
-namespace WS2812B
-{
-  StripGroup::StripGroup(Strip* strips, uint16_t len) : strips{strips}, strip_count{len}, bright{255}
+  void HSVStepper::setValue(uint8_t val)
   {
-    calcLEDsCount();
+    scale = HSVScale(scale.sat, val);
   }
 
-  StripGroup::StripGroup() : StripGroup(nullptr, 0) {}
-
-  bool StripGroup::begin()
+  uint8_t HSVStepper::getSaturation() const
   {
-    for (uint16_t i = 0; i < strip_count; ++i) strips[i].begin();
-    return isBegin();
+    return scale.sat;
   }
 
-  bool StripGroup::isBegin() const
+  uint8_t HSVStepper::getValue() const
   {
-    if (strip_count == 0) return 0;
-    for (uint16_t i = 0; i < strip_count; ++i)
-    {
-      if (!strips[i].is_begin) return 0;
-    }
-    return 1;
+    return scale.val;
   }
 
-  void StripGroup::calcLEDsCount()
+  Color HSVStepper::next()
   {
-    led_count = 0u;
-    for (uint16_t i = 0; i < strip_count; ++i) led_count += strips[i].count;
+    Color c = hsvSector(sector, pos >> 8, scale);
+    sector += step_sectors;
+    if (pos >= WS2812B_HSV_SECTOR_SIZE - step_pos) // pos + step_pos would leave the sector (and 16 bits)
+    {
+      pos -= WS2812B_HSV_SECTOR_SIZE - step_pos;
+      ++sector;
+    }
+    else pos += step_pos;
+    if (sector >= 6) sector -= 6;
+    return c;
   }
 
-  void StripGroup::changeStripsConfig(Strip* _strips, uint16_t _len)
+  void HSVStepper::fill(LED* leds, uint16_t len)
   {
-    strips = _strips;
-    strip_count = _len;
-    calcLEDsCount();
+    if (leds == nullptr) return;
+    for (uint16_t i = 0; i < len; ++i) leds[i] = next();
   }
 
-  uint32_t StripGroup::numPixels() const
+  void fillRainbow(LED* leds, uint16_t len, uint16_t start_hue, int16_t delta_hue, uint8_t sat, uint8_t val)
   {
-    return led_count;
+    HSVStepper(start_hue, delta_hue, sat, val).fill(leds, len);
   }
 
-  LED& StripGroup::operator[](uint32_t led)
+  void fillGradientHSV(LED* leds, uint16_t len, uint16_t hue_from, uint16_t hue_to, uint8_t sat, uint8_t val)
   {
-    if (strips == nullptr || led >= led_count) return void_led;
-    return getLedReference(led);
+    if (leds == nullptr || len == 0) return;
+    int16_t step = len > 1 ? (int16_t)(hue_to - hue_from) / (int16_t)(len - 1) : 0;
+    HSVStepper(hue_from, step, sat, val).fill(leds, len);
   }
 
-  void StripGroup::fill(uint32_t color)
+  // 8.8 fixed point per channel, one add per channel per LED
+  void fillGradientRGB(LED* leds, uint16_t len, const Color& from, const Color& to)
   {
-    if (strips == nullptr) return;
-    for (uint16_t i = 0; i < strip_count; ++i) 
+    if (leds == nullptr || len == 0) return;
+    uint16_t n = len > 1 ? len - 1 : 1;
+    int16_t dr = ((int32_t)(to.r - from.r) << 8) / n;
+    int16_t dg = ((int32_t)(to.g - from.g) << 8) / n;
+    int16_t db = ((int32_t)(to.b - from.b) << 8) / n;
+    uint16_t r = (from.r << 8) | 0x80, g = (from.g << 8) | 0x80, b = (from.b << 8) | 0x80;
+    for (uint16_t i = 0; i < len; ++i)
     {
-      strips[i].fill(color);
+      leds[i].r = r >> 8;
+      leds[i].g = g >> 8;
+      leds[i].b = b >> 8;
+      r += dr, g += dg, b += db;
     }
+    leds[len - 1] = to;
   }
 
-  void StripGroup::fillFromTo(uint32_t color, uint32_t from, uint32_t to)
+
+  static inline uint8_t convert16(uint16_t v, uint16_t k, bool gamma)
   {
-    if (from > to || to >= led_count) return;
-    for (uint32_t i = from; i <= to; ++i)
+    if (gamma)
     {
-      getLedReference(i) = color;
+      // interpolate between gamma table entries with the low byte
+      uint8_t hi = v >> 8;
+      uint8_t g0 = pgm_read_byte(&__GAMMA8_TABLE[hi]);
+      uint8_t g1 = hi < 255 ? pgm_read_byte(&__GAMMA8_TABLE[hi + 1]) : 255u;
+      v = (uint16_t)((g0 << 8) + (int16_t)(g1 - g0) * (uint8_t)v);
     }
+    return (uint8_t)(((uint32_t)v * k) >> 16);
   }
 
-  void StripGroup::fill(uint8_t r, uint8_t g, uint8_t b)
+  static inline void convert16(LED& dst, const LED16& src, uint16_t k, bool gamma)
   {
-    if (strips == nullptr) return;
-    for (uint16_t i = 0; i < strip_count; ++i) strips[i].fill(r, g, b);
+    dst.r = convert16(src.r, k, gamma);
+    dst.g = convert16(src.g, k, gamma);
+    dst.b = convert16(src.b, k, gamma);
   }
 
-  void StripGroup::fillFromTo(uint8_t r, uint8_t g, uint8_t b, uint32_t from, uint32_t to)
+  // step = -1 writes dst backwards (reversed strip)
+  static void convert(LED* dst, int8_t step, const LED16* src, uint16_t len, uint8_t bright, bool gamma)
   {
-    if (from > to || to >= led_count) return;
-    for (uint32_t i = from; i <= to; ++i)
+    if (dst == nullptr || src == nullptr) return;
+    uint16_t k = bright + 1u;
+#ifndef AVR
+    for (; len >= 4; len -= 4, src += 4, dst += 4 * step)
     {
-      getLedReference(i) = {r, g, b};
+      convert16(dst[0], src[0], k, gamma);
+      convert16(dst[step], src[1], k, gamma);
+      convert16(dst[2 * step], src[2], k, gamma);
+      convert16(dst[3 * step], src[3], k, gamma);
     }
+#endif
+    for (; len; --len, ++src, dst += step) convert16(*dst, *src, k, gamma);
   }
 
-  void StripGroup::fill(const Color& led_color)
+  void convert(LED* dst, const LED16* src, uint16_t len, uint8_t bright, bool gamma)
   {
-    if (strips == nullptr) return;
-    for (uint16_t i = 0; i < strip_count; ++i) strips[i].fill(led_color);
+    convert(dst, 1, src, len, bright, gamma);
   }
 
-  void StripGroup::fillFromTo(const Color& led_color, uint32_t from, uint32_t to)
+  void transpose8(const uint8_t* values, const uint8_t* masks, uint8_t n, uint8_t base, uint8_t* out)
   {
-    if (from > to || to >= led_count) return;
-    for (uint32_t i = from; i <= to; ++i)
+    for (uint8_t k = 0; k < 8; ++k) out[k] = base;
+    for (uint8_t s = 0; s < n; ++s)
     {
-      getLedReference(i) = led_color;
+      uint8_t v = values[s];
+      uint8_t m = masks[s];
+      for (uint8_t k = 0; k < 8; ++k, v <<= 1)
+      {
+        if (v & 0x80) out[k] |= m;
+      }
     }
   }
 
-  uint16_t StripGroup::getStripByLED(uint32_t led) const
+  uint32_t& pinTimer(uint8_t pin)
   {
-    if (strips == nullptr) return 0;
-    for (uint16_t i = 0; i < strip_count; ++i)
+    static uint8_t pins[WS2812B_PIN_TIMERS];
+    static uint32_t timers[WS2812B_PIN_TIMERS];
+    static uint8_t used = 0;
+    uint32_t now = micros();
+    uint8_t oldest = 0;
+    for (uint8_t i = 0; i < used; ++i)
     {
-      if (led < strips[i].count) return i;
-      led -= strips[i].count;
-    } 
-    return 0;
+      if (pins[i] == pin) return timers[i];
+      if (now - timers[i] > now - timers[oldest]) oldest = i;
+    }
+    // a reused slot keeps its time, the new pin waits at most for the rest of that latch
+    if (used < WS2812B_PIN_TIMERS) oldest = used++;
+    pins[oldest] = pin;
+    return timers[oldest];
   }
 
-  void StripGroup::show()
+  uint16_t transposeFrame(const uint8_t* const* bytes, const uint16_t* lens, const uint8_t* masks, uint8_t n, uint8_t bright, uint8_t* out, uint16_t size)
   {
-    if (strips == nullptr) return;
-    for (uint16_t i = 0; i < strip_count; ++i)
+    if (out == nullptr || n > WS2812B_PARALLEL_MAX) return 0;
+    uint16_t longest = 0;
+    for (uint8_t s = 0; s < n; ++s)
     {
-      if (strips[i].is_begin) WS2812B::show(strips[i].leds, strips[i].count, strips[i].pin, bright);
+      if (lens[s] > longest) longest = lens[s];
     }
+    if (size == 0 || longest > (size - 1u) / 8u) return 0;
+
+    uint8_t values[WS2812B_PARALLEL_MAX];
+    for (uint16_t i = 0; i < longest; ++i, out += 8)
+    {
+      for (uint8_t s = 0; s < n; ++s) values[s] = i < lens[s] ? (uint8_t)((bytes[s][i] * bright) >> 8) : 0u;
+      transpose8(values, masks, n, 0u, out);
+    }
+    *out = 0u;
+    return longest * 8u;
   }
 
-  void StripGroup::show(uint16_t strip)
+}
+
+// ############################################################################################################################
+
+static  WS2812B::LED void_led{0};
+
+// ########################################### WS2812B_OUTPUT_STAGE ###########################################################
+
+namespace WS2812B
+{
+  OutputStage::OutputStage(LED* buffer, uint16_t len) 
+  : buffer{buffer}, 
+    len{len}, 
+    gamma{0}, 
+    stale{1}, 
+    lut_bright{255}, 
+    balance{0xffffff} 
+#if WS2812B_DITHER
+    , dither{nullptr},
+    dither_len{0}
+#endif
+  {}
+
+  OutputStage::OutputStage() : OutputStage(nullptr, 0u) {}
+
+  void OutputStage::changeBufferConfig(LED* _buffer, uint16_t _len)
   {
-    if (strips == nullptr || strip >= strip_count || !strips[strip].is_begin) return; 
-    WS2812B::_extern_timer_show(strips[strip].leds, strips[strip].count, strips[strip].pin, bright, strips[strip].timer);
+    buffer = _buffer;
+    len = _len;
   }
 
-  void StripGroup::show(bool* strip_update_list, bool reset_list)
+  uint16_t OutputStage::size() const
   {
-    if (!isBegin()) return;
-    for (uint16_t i = 0; i < strip_count; ++i)
-    {
-      if (strip_update_list[i]) WS2812B::show(strips[i].leds, strips[i].count, strips[i].pin, bright);
-      if (reset_list) strip_update_list[i] = false;
-    }
+    return buffer ? len : 0;
   }
 
-  void StripGroup::clear()
+  void OutputStage::setGamma(bool enable)
   {
-    if (strips == nullptr) return;
-    for (uint16_t i = 0; i < strip_count; ++i) strips[i].clear();
+    if (gamma != enable) stale = true;
+    gamma = enable;
   }
 
-  Strip* StripGroup::getStripPtr(uint16_t index) const
+  bool OutputStage::getGamma() const
   {
-    if (index < strip_count) return (strips+index);
-    return nullptr;
+    return gamma;
   }
 
-  uint16_t StripGroup::numStrips() const
+  void OutputStage::setWhiteBalance(uint8_t r, uint8_t g, uint8_t b)
   {
-    return strip_count;
+    if (balance != Color(r, g, b)) stale = true;
+    balance = Color(r, g, b);
   }
 
-  uint8_t StripGroup::getBrightness() const
+  void OutputStage::setWhiteBalance(uint32_t color)
   {
-    return bright;
+    setWhiteBalance((uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color);
   }
 
-  uint32_t StripGroup::getPixelColor(uint32_t n) const
+  Color OutputStage::getWhiteBalance() const
   {
-    if (n >= led_count) return 0;
-    return getLedReference(n);
+    return balance;
   }
 
-  void StripGroup::setBrightness(uint8_t b)
+  // x * (k + 1) >> 8 keeps 255 as identity for both balance and brightness
+  void OutputStage::rebuild(uint8_t bright)
   {
-    bright = b;
+    const uint8_t factors[3] = {balance.g, balance.r, balance.b};
+    for (uint8_t c = 0; c < 3; ++c)
+    {
+      uint16_t k = (uint16_t)(((factors[c] + 1u) * (bright + 1u)) >> 8); // 1 to 256, 256 keeps v
+      uint16_t i = 0;
+      do
+      {
+        uint8_t v = gamma ? pgm_read_byte(&__GAMMA8_TABLE[i]) : (uint8_t)i;
+        lut[c][i] = (uint8_t)((v * k) >> 8);
+      } while (++i < 256);
+    }
+    lut_bright = bright;
+    stale = false;
   }
 
-  void StripGroup::setPixelColor(uint32_t n, uint32_t color)
+  const LED* OutputStage::render(const LED* leds, uint16_t n, uint8_t bright)
   {
-    if (n >= led_count) return;
-    getLedReference(n) = color;
+    if (buffer == nullptr || leds == nullptr) return buffer;
+    if (n > len) n = len;
+#if WS2812B_DITHER
+    if (isDithering())
+    {
+      renderDithered(leds, n, bright);
+      return buffer;
+    }
+#endif
+    if (stale || bright != lut_bright) rebuild(bright);
+
+    const uint8_t* src = (const uint8_t*)leds;
+    uint8_t* dst = (uint8_t*)buffer;
+    for (uint16_t i = 0; i < n; ++i, src += 3, dst += 3)
+    {
+      dst[0] = lut[0][src[0]];
+      dst[1] = lut[1][src[1]];
+      dst[2] = lut[2][src[2]];
+    }
+    return buffer;
   }
 
-  void StripGroup::setPixelColor(uint32_t n, uint8_t r, uint8_t g, uint8_t b)
+#if WS2812B_DITHER
+  void OutputStage::setDitherBuffer(uint8_t* errors, uint16_t n)
   {
-    if (n >= led_count) return;
-    getLedReference(n) = {r, g, b};
+    dither = errors;
+    dither_len = errors ? n : 0;
+    // different start phase per channel, otherwise all LEDs of one color step up in the same frame
+    for (uint16_t i = 0; i < dither_len * 3u; ++i) dither[i] = (uint8_t)(i * 97u);
   }
 
-  LED& StripGroup::getLedReference(uint32_t n) const
+  bool OutputStage::isDithering() const
   {
-    for (uint16_t i = 0; i < strip_count; ++i)
+    return dither != nullptr;
+  }
+
+  /**
+   * Scaled value is kept as 8.8 fixed point, the fractional part is accumulated per pixel
+   * and carried into the integer part on successive frames, so the mean output over
+   * several frames follows the unquantized value also at very low brightness.
+   */
+  void OutputStage::renderDithered(const LED* leds, uint16_t n, uint8_t bright)
+  {
+    const uint8_t factors[3] = {balance.g, balance.r, balance.b};
+    uint16_t k[3];
+    for (uint8_t c = 0; c < 3; ++c) k[c] = (uint16_t)(((factors[c] + 1u) * (bright + 1u)) >> 8);
+
+    const uint8_t* src = (const uint8_t*)leds;
+    uint8_t* dst = (uint8_t*)buffer;
+    uint8_t* err = dither;
+    uint16_t count = n * 3u;
+    uint16_t with_error = (n < dither_len ? n : dither_len) * 3u;
+    for (uint16_t i = 0; i < count; ++i)
     {
-      if (n < strips[i].count)
+      uint8_t c = i % 3;
+      uint8_t v = gamma ? pgm_read_byte(&__GAMMA8_TABLE[src[i]]) : src[i];
+      uint16_t scaled = v * k[c];
+      uint8_t out = (uint8_t)(scaled >> 8);
+      if (i < with_error)
       {
-        if (strips[i].reverse)
-        {
-          return strips[i].leds[strips[i].count - 1 - n];
-        }
-        return strips[i].leds[n];
+        uint16_t sum = (uint8_t)scaled + err[i];
+        err[i] = (uint8_t)sum;
+        if ((sum >> 8) && out < 255) ++out;
       }
-      n -= strips[i].count;
+      dst[i] = out;
     }
-    return void_led;
+  }
+#endif
+}
+
+// ############################################################################################################################
+
+// ########################################### WS2812B_STRIP ##################################################################
+
+
+namespace WS2812B
+{
+  extern uint8_t _extern_pin_port(uint8_t pin);
+
+  Strip::Strip(LED* leds, uint16_t len, uint8_t pin, bool reverse) 
+  : is_begin{0}, 
+    leds{leds}, 
+    front{nullptr}, 
+    copy_forward{1}, 
+    count{len}, 
+    pin{pin}, 
+    reverse{reverse}, 
+    timer{0}, 
+    tracking{0},
+    dirty{1},
+    pending{0},
+    sent_bright{255},
+    frames_sent{0},
+    frames_skipped{0},
+    stage{nullptr},
+    power_budget{0u},
+    ma_channel{20u},
+    ma_idle{1u},
+    sum_valid{0},
+    channel_sum{0u},
+    estimated_ma{0u},
+    applied_bright{255},
+    bright{255} 
+  {}
+
+  Strip::Strip() : Strip(nullptr, 0u, 255u, 0) {}
+
+  bool Strip::begin()
+  {
+    is_begin = WS2812B::begin(pin);
+    return is_begin;
+  }
+
+  void Strip::setPin(uint8_t p)
+  {
+    pin = p;
+    dirty = true;
+    begin();
+  }
+
+  uint8_t Strip::getPin() const
+  {
+    return pin;
+  }
+
+  void Strip::changeLEDsConfig(LED* _leds, uint16_t len)
+  {
+    WS2812B::waitShowDone(pin);
+    leds = _leds;
+    front = nullptr;
+    count = len;
+    dirty = true;
+  }
+
+  void Strip::changeLEDsConfig(LED* _front, LED* _back, uint16_t len)
+  {
+    changeLEDsConfig(_back, len);
+    front = _front;
+  }
+
+  bool Strip::isDoubleBuffered() const
+  {
+    return front != nullptr;
+  }
+
+  void Strip::setCopyForward(bool enable)
+  {
+    copy_forward = enable;
+  }
+
+  bool Strip::isCopyForward() const
+  {
+    return copy_forward;
+  }
+
+  // last sent frame, owned by the transmitter until waitShowDone() on async platforms
+  const LED* Strip::getFrontBuffer() const
+  {
+    return front ? front : leds;
+  }
+
+  LED& Strip::operator[](uint16_t led)
+  {
+    if (leds == nullptr || led >= count) return void_led;
+    dirty = true;
+    if (reverse) return leds[count - 1 - led];
+    return leds[led];
+  } 
+
+  uint16_t Strip::numPixels() const
+  {
+    return count;
+  }
+
+  bool Strip::isReverse() const
+  {
+    return reverse;
+  }
+
+  void Strip::setReverse(bool r)
+  {
+    if (reverse != r) dirty = true;
+    reverse = r;
+  }
+
+  void Strip::fill(uint32_t color)
+  {
+    dirty = true;
+    WS2812B::fill(leds, count, color);
+  }
+
+  void Strip::fillFromTo(uint32_t color, uint16_t from, uint16_t to)
+  {
+    dirty = true;
+    if (!reverse) return WS2812B::fillFromTo(leds, count, color, from, to);
+    if (from > to || to >= count) return;
+    WS2812B::fillFromTo(leds, count, color, count - 1 - to, count - 1 - from);
+  }
+
+  void Strip::fill(uint8_t r, uint8_t g, uint8_t b)
+  {
+    dirty = true;
+    WS2812B::fill(leds, count, r, g, b);
+  }
+
+  void Strip::fillFromTo(uint8_t r, uint8_t g, uint8_t b, uint16_t from, uint16_t to)
+  {
+    dirty = true;
+    if (!reverse) return WS2812B::fillFromTo(leds, count, r, g, b, from, to);
+    if (from > to || to >= count) return;
+    WS2812B::fillFromTo(leds, count, r, g, b, count - 1 - to, count - 1 - from);
+  }
+
+  void Strip::fillFromTo(const Color& color, uint16_t from, uint16_t to)
+  {
+    dirty = true;
+    if (!reverse) return WS2812B::fillFromTo(leds, count, color, from, to);
+    if (from > to || to >= count) return;
+    WS2812B::fillFromTo(leds, count, color, count - 1 - to, count - 1 - from);
+  }
+
+  // palette index runs from the first logical LED, also on reversed strips
+  void Strip::fillFromPalette(const Palette16& palette, uint8_t start_index, uint8_t step, uint8_t b, bool blend)
+  {
+    dirty = true;
+    if (!reverse) return WS2812B::fillFromPalette(leds, count, palette, start_index, step, b, blend);
+    if (count == 0) return;
+    WS2812B::fillFromPalette(leds, count, palette, start_index + step * (count - 1), -step, b, blend);
+  }
+
+  void Strip::fillFromPalette_P(const uint32_t* palette, uint8_t start_index, uint8_t step, uint8_t b, bool blend)
+  {
+    if (palette == nullptr) return;
+    Palette16 p;
+    p.load_P(palette);
+    fillFromPalette(p, start_index, step, b, blend);
+  }
+
+  void Strip::composite(const Layer* layers, uint8_t count)
+  {
+    dirty = true;
+    compositeInto(leds, this->count, layers, count, reverse);
+  }
+
+  void Strip::fill(const Color& color)
+  {
+    dirty = true;
+    WS2812B::fill(leds, count, color);
+  }
+
+  void Strip::clear()
+  {
+    dirty = true;
+    WS2812B::clear(leds, count);
+  }
+
+  void Strip::show()
+  {
+    if (!is_begin) return;
+    uint8_t b = limitPower(bright);
+    if (!needsShow(b))
+    {
+      ++frames_skipped;
+      return;
+    }
+    transmit(b);
+  }
+
+  bool Strip::needsShow(uint8_t b) const
+  {
+#if WS2812B_DITHER
+    if (stage && stage->isDithering()) return true; // every frame moves the dither
+#endif
+    return !tracking || dirty || b != sent_bright;
+  }
+
+  void Strip::transmit(uint8_t b)
+  {
+    if (stage && stage->size() >= count)
+    {
+      WS2812B::waitShowDone(pin); // stage buffer may still be on the wire
+      const LED* out = stage->render(leds, count, b);
+      WS2812B::_extern_timer_show_raw((const uint8_t*)out, count * 3, pin, timer);
+    }
+    else WS2812B::_extern_timer_show(leds, count, pin, b, timer);
+    markSent(b);
+  }
+
+  void Strip::setOutputStage(OutputStage* s)
+  {
+    stage = s;
+    dirty = true;
+  }
+
+  OutputStage* Strip::getOutputStage() const
+  {
+    return stage;
+  }
+
+  /**
+   * Double buffered strip swaps after the frame is handed over: the drawn buffer becomes front
+   * and stays with the transmitter, drawing continues in the previous front. The platform
+   * show waits for the previous frame on the pin before sending, so that buffer is free here.
+   */
+  void Strip::markSent(uint8_t b)
+  {
+    if (front)
+    {
+      LED* sent = leds;
+      leds = front;
+      front = sent;
+      if (copy_forward) memcpy((uint8_t*)leds, (const uint8_t*)front, count * 3);
+      else sum_valid = false; // drawing continues in the older frame
+    }
+    dirty = false;
+    sent_bright = b;
+    ++frames_sent;
+  }
+
+  void Strip::setChangeTracking(bool enable)
+  {
+    tracking = enable;
+    dirty = true;
+  }
+
+  bool Strip::isChangeTracking() const
+  {
+    return tracking;
+  }
+
+  bool Strip::isDirty() const
+  {
+    return dirty || bright != sent_bright;
+  }
+
+  void Strip::markDirty()
+  {
+    dirty = true;
+  }
+
+  uint32_t Strip::framesSent() const
+  {
+    return frames_sent;
+  }
+
+  uint32_t Strip::framesSkipped() const
+  {
+    return frames_skipped;
+  }
+
+  void Strip::resetFrameCounters()
+  {
+    frames_sent = frames_skipped = 0u;
+  }
+
+  /**
+   * Current of a frame = ma_idle per LED + ma_channel per channel at 255, scaled by the brightness
+   * the transmitter applies ((v * b) >> 8). With change tracking an unchanged frame reuses the
+   * channel sum of the last estimate, without it the buffer may have been written directly and
+   * the sum is read again every time. Values are taken before
+   * the output stage, so gamma and white balance only make the estimate more conservative.
+   */
+  static uint8_t powerLimit(uint32_t sum, uint32_t leds, uint16_t budget, uint8_t ma_channel, uint8_t ma_idle, uint8_t b, uint32_t& estimate)
+  {
+    uint32_t idle = leds * ma_idle;
+    uint32_t full = (uint32_t)(((uint64_t)sum * ma_channel) / 255u);
+    if (idle + ((full * b) >> 8) > budget)
+    {
+      uint32_t fit = budget > idle ? ((budget - idle) << 8) / full : 0u;
+      b = fit < b ? (uint8_t)fit : b;
+    }
+    estimate = idle + ((full * b) >> 8);
+    return b;
+  }
+
+  uint32_t Strip::channelSum()
+  {
+    if (!tracking || dirty || !sum_valid)
+    {
+      const uint8_t* bytes = (const uint8_t*)leds;
+      uint32_t sum = 0u;
+      if (bytes) for (uint16_t i = 0; i < count * 3; ++i) sum += bytes[i];
+      channel_sum = sum;
+      sum_valid = true;
+    }
+    return channel_sum;
+  }
+
+  uint8_t Strip::limitPower(uint8_t b)
+  {
+    applied_bright = b;
+    if (power_budget == 0u) return b;
+    applied_bright = powerLimit(channelSum(), count, power_budget, ma_channel, ma_idle, b, estimated_ma);
+    return applied_bright;
+  }
+
+  void Strip::setPowerBudget(uint16_t milliamps, uint8_t ma_per_channel, uint8_t ma_idle_per_led)
+  {
+    power_budget = milliamps;
+    ma_channel = ma_per_channel;
+    ma_idle = ma_idle_per_led;
+    sum_valid = false;
+    estimated_ma = 0u;
+  }
+
+  uint16_t Strip::getPowerBudget() const
+  {
+    return power_budget;
+  }
+
+  uint32_t Strip::getEstimatedCurrent() const
+  {
+    return estimated_ma;
+  }
+
+  uint8_t Strip::getAppliedBrightness() const
+  {
+    return applied_bright;
+  }
+
+  void Strip::waitShowDone()
+  {
+    WS2812B::waitShowDone(pin);
+  }
+
+  bool Strip::canShow() const
+  {
+    return _extern_can_show(pin, timer);
+  }
+
+  uint8_t Strip::getBrightness() const
+  {
+    return bright;
+  }
+
+  Color Strip::getPixelColor(uint16_t n) const
+  {
+    if (leds == nullptr || n >= count) return 0;
+    return leds[reverse ? count - 1 - n : n];
+  }
+
+  void Strip::setBrightness(uint8_t b)
+  {
+    bright = b;
+  }
+
+  void Strip::setPixelColor(uint16_t n, uint32_t color)
+  {
+    if (leds == nullptr || n >= count) return;
+    dirty = true;
+    leds[reverse ? count - 1 - n : n] = color;
+  }
+
+  void Strip::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+  {
+    if (leds == nullptr || n >= count) return;
+    dirty = true;
+    LED& led = leds[reverse ? count - 1 - n : n];
+    led.r = r; led.g = g; led.b = b;
+  }
+
+  void Strip::setPixelColor(uint16_t n, Color color)
+  {
+    if (leds == nullptr || n >= count) return;
+    dirty = true;
+    leds[reverse ? count - 1 - n : n] = color;
+  }
+
+  // span is clipped to the strip, on reversed strips it is copied as one backward block
+  uint16_t Strip::writePixels(uint16_t offset, const LED* src, uint16_t n)
+  {
+    if (leds == nullptr || src == nullptr || offset >= count) return 0u;
+    if (n > count - offset) n = count - offset;
+    dirty = true;
+    if (reverse) copyPixels(leds + (count - 1 - offset), -1, src, n);
+    else copyPixels(leds + offset, 1, src, n);
+    return n;
+  }
+
+  uint16_t Strip::writePixelsRGB(uint16_t offset, const uint8_t* src, uint16_t n, ColorOrder order)
+  {
+    if (leds == nullptr || src == nullptr || offset >= count) return 0u;
+    if (n > count - offset) n = count - offset;
+    dirty = true;
+    if (reverse) copyPixelsRGB(leds + (count - 1 - offset), -1, src, n, order);
+    else copyPixelsRGB(leds + offset, 1, src, n, order);
+    return n;
+  }
+
+  uint16_t Strip::readPixels(uint16_t offset, LED* dst, uint16_t n) const
+  {
+    if (leds == nullptr || dst == nullptr || offset >= count) return 0u;
+    if (n > count - offset) n = count - offset;
+    if (reverse) WS2812B::readPixels(dst, leds + (count - 1 - offset), -1, n);
+    else WS2812B::readPixels(dst, leds + offset, 1, n);
+    return n;
+  }
+
+}
+
+// #############################################################################################################################
+
+
+
+// ############################################ WS2812B_STRIP_GROUP ############################################################
+
+namespace WS2812B
+{
+  StripGroup::StripGroup(Strip* strips, uint16_t len, uint32_t* offsets) 
+  : strips{strips}, strip_count{len}, offsets{offsets}, power_budget{0u}, ma_channel{20u}, ma_idle{1u}, estimated_ma{0u}, applied_bright{255}, parallel_buffer{nullptr}, parallel_size{0u}, bright{255}
+  {
+    calcLEDsCount();
+  }
+
+  StripGroup::StripGroup(Strip* strips, uint16_t len) : StripGroup(strips, len, nullptr) {}
+
+  StripGroup::StripGroup() : StripGroup(nullptr, 0) {}
+
+  bool StripGroup::begin()
+  {
+    for (uint16_t i = 0; i < strip_count; ++i) strips[i].begin();
+    return isBegin();
+  }
+
+  bool StripGroup::isBegin() const
+  {
+    if (strip_count == 0) return 0;
+    for (uint16_t i = 0; i < strip_count; ++i)
+    {
+      if (!strips[i].is_begin) return 0;
+    }
+    return 1;
+  }
+
+  void StripGroup::calcLEDsCount()
+  {
+    led_count = 0u;
+    for (uint16_t i = 0; i < strip_count; ++i) 
+    {
+      if (offsets) offsets[i] = led_count;
+      led_count += strips[i].count;
+    }
+    if (offsets) offsets[strip_count] = led_count;
+  }
+
+  void StripGroup::changeStripsConfig(Strip* _strips, uint16_t _len)
+  {
+    strips = _strips;
+    strip_count = _len;
+    calcLEDsCount();
+  }
+
+  void StripGroup::changeStripsConfig(Strip* _strips, uint16_t _len, uint32_t* _offsets)
+  {
+    offsets = _offsets;
+    changeStripsConfig(_strips, _len);
+  }
+
+  uint16_t StripGroup::locate(uint32_t& n) const
+  {
+    if (offsets)
+    {
+      // offsets[lo] <= n < offsets[hi]
+      uint16_t lo = 0, hi = strip_count;
+      while (hi - lo > 1)
+      {
+        uint16_t mid = (lo + hi) >> 1;
+        if (offsets[mid] <= n) lo = mid;
+        else hi = mid;
+      }
+      n -= offsets[lo];
+      return lo;
+    }
+    for (uint16_t i = 0; i < strip_count; ++i)
+    {
+      if (n < strips[i].count) return i;
+      n -= strips[i].count;
+    }
+    return strip_count;
+  }
+
+  uint32_t StripGroup::numPixels() const
+  {
+    return led_count;
+  }
+
+  LED& StripGroup::operator[](uint32_t led)
+  {
+    if (strips == nullptr || led >= led_count) return void_led;
+    return getLedReference(led);
+  }
+
+  void StripGroup::fill(uint32_t color)
+  {
+    if (strips == nullptr) return;
+    for (uint16_t i = 0; i < strip_count; ++i) 
+    {
+      strips[i].fill(color);
+    }
+  }
+
+  void StripGroup::fillFromTo(uint32_t color, uint32_t from, uint32_t to)
+  {
+    fillFromTo(Color(color), from, to);
+  }
+
+  void StripGroup::fill(uint8_t r, uint8_t g, uint8_t b)
+  {
+    if (strips == nullptr) return;
+    for (uint16_t i = 0; i < strip_count; ++i) strips[i].fill(r, g, b);
+  }
+
+  void StripGroup::fillFromTo(uint8_t r, uint8_t g, uint8_t b, uint32_t from, uint32_t to)
+  {
+    fillFromTo(Color(r, g, b), from, to);
+  }
+
+  void StripGroup::fill(const Color& led_color)
+  {
+    if (strips == nullptr) return;
+    for (uint16_t i = 0; i < strip_count; ++i) strips[i].fill(led_color);
+  }
+
+  void StripGroup::fillFromPalette(const Palette16& palette, uint8_t start_index, uint8_t step, uint8_t b, bool blend)
+  {
+    if (strips == nullptr) return;
+    uint8_t index = start_index;
+    for (uint16_t i = 0; i < strip_count; ++i)
+    {
+      strips[i].fillFromPalette(palette, index, step, b, blend);
+      index += step * strips[i].count;
+    }
+  }
+
+  void StripGroup::fillFromPalette_P(const uint32_t* palette, uint8_t start_index, uint8_t step, uint8_t b, bool blend)
+  {
+    if (palette == nullptr) return;
+    Palette16 p;
+    p.load_P(palette);
+    fillFromPalette(p, start_index, step, b, blend);
+  }
+
+  void StripGroup::fillFromTo(const Color& led_color, uint32_t from, uint32_t to)
+  {
+    if (strips == nullptr || from > to || to >= led_count) return;
+    uint32_t first = from;
+    uint32_t remaining = to - from + 1;
+    for (uint16_t i = locate(first); remaining && i < strip_count; ++i, first = 0)
+    {
+      uint32_t span = strips[i].count - first;
+      if (span > remaining) span = remaining;
+      if (span == 0) continue;
+      strips[i].fillFromTo(led_color, first, first + span - 1);
+      remaining -= span;
+    }
+  }
+
+  uint16_t StripGroup::getStripByLED(uint32_t led) const
+  {
+    if (strips == nullptr || led >= led_count) return 0;
+    return locate(led);
+  }
+
+  void StripGroup::show()
+  {
+    if (strips == nullptr) return;
+    uint8_t b = limitPower();
+    for (uint16_t i = 0; i < strip_count; ++i)
+    {
+      strips[i].pending = strips[i].is_begin && strips[i].needsShow(b);
+      if (strips[i].is_begin && !strips[i].pending) ++strips[i].frames_skipped;
+    }
+
+    // strips with an output stage are sent on their own, the rest in parallel batches
+    for (uint16_t i = 0; i < strip_count; ++i)
+    {
+      if (!strips[i].pending || strips[i].stage == nullptr) continue;
+      strips[i].transmit(b);
+      strips[i].pending = false;
+    }
+
+    Strip* batch[WS2812B_PARALLEL_MAX];
+    for (uint16_t i = 0; i < strip_count; ++i)
+    {
+      if (!strips[i].pending) continue;
+      uint8_t port = _extern_pin_port(strips[i].pin);
+
+      // strip was already sent by the first strip of its batch
+      uint16_t before = 0;
+      for (uint16_t j = 0; j < i; ++j)
+      {
+        if (strips[j].pending && _extern_pin_port(strips[j].pin) == port) ++before;
+      }
+      if (before % WS2812B_PARALLEL_MAX) continue;
+
+      uint8_t n = 0;
+      for (uint16_t j = i; j < strip_count && n < WS2812B_PARALLEL_MAX; ++j)
+      {
+        if (strips[j].pending && _extern_pin_port(strips[j].pin) == port) batch[n++] = &strips[j];
+      }
+      _extern_parallel_show(batch, n, b, parallel_buffer, parallel_size);
+      for (uint8_t k = 0; k < n; ++k) batch[k]->markSent(b);
+    }
+
+    for (uint16_t i = 0; i < strip_count; ++i) strips[i].pending = false;
+  }
+
+  void StripGroup::show(uint16_t strip)
+  {
+    if (strips == nullptr || strip >= strip_count || !strips[strip].is_begin) return; 
+    uint8_t b = limitPower();
+    if (!strips[strip].needsShow(b))
+    {
+      ++strips[strip].frames_skipped;
+      return;
+    }
+    strips[strip].transmit(b);
+  }
+
+  void StripGroup::show(bool* strip_update_list, bool reset_list)
+  {
+    if (!isBegin()) return;
+    uint8_t b = limitPower();
+    for (uint16_t i = 0; i < strip_count; ++i)
+    {
+      if (strip_update_list[i]) strips[i].transmit(b);
+      if (reset_list) strip_update_list[i] = false;
+    }
+  }
+
+  // one budget for all strips of the group, every strip keeps its cached channel sum
+  uint8_t StripGroup::limitPower()
+  {
+    applied_bright = bright;
+    if (power_budget == 0u || strips == nullptr) return bright;
+    uint32_t sum = 0u;
+    for (uint16_t i = 0; i < strip_count; ++i) sum += strips[i].channelSum();
+    applied_bright = powerLimit(sum, led_count, power_budget, ma_channel, ma_idle, bright, estimated_ma);
+    return applied_bright;
+  }
+
+  void StripGroup::setPowerBudget(uint16_t milliamps, uint8_t ma_per_channel, uint8_t ma_idle_per_led)
+  {
+    power_budget = milliamps;
+    ma_channel = ma_per_channel;
+    ma_idle = ma_idle_per_led;
+    estimated_ma = 0u;
+  }
+
+  uint16_t StripGroup::getPowerBudget() const
+  {
+    return power_budget;
+  }
+
+  uint32_t StripGroup::getEstimatedCurrent() const
+  {
+    return estimated_ma;
+  }
+
+  uint8_t StripGroup::getAppliedBrightness() const
+  {
+    return applied_bright;
+  }
+
+  void StripGroup::setParallelBuffer(uint8_t* buffer, uint16_t size)
+  {
+    parallel_buffer = buffer;
+    parallel_size = buffer ? size : 0u;
+  }
+
+  void StripGroup::setChangeTracking(bool enable)
+  {
+    if (strips == nullptr) return;
+    for (uint16_t i = 0; i < strip_count; ++i) strips[i].setChangeTracking(enable);
+  }
+
+  void StripGroup::clear()
+  {
+    if (strips == nullptr) return;
+    for (uint16_t i = 0; i < strip_count; ++i) strips[i].clear();
+  }
+
+  Strip* StripGroup::getStripPtr(uint16_t index) const
+  {
+    if (index < strip_count) return (strips+index);
+    return nullptr;
+  }
+
+  uint16_t StripGroup::numStrips() const
+  {
+    return strip_count;
+  }
+
+  uint8_t StripGroup::getBrightness() const
+  {
+    return bright;
+  }
+
+  uint32_t StripGroup::getPixelColor(uint32_t n) const
+  {
+    if (n >= led_count) return 0;
+    const Strip& s = strips[locate(n)];
+    return s.leds[s.reverse ? s.count - 1 - n : n];
+  }
+
+  void StripGroup::setBrightness(uint8_t b)
+  {
+    bright = b;
+  }
+
+  void StripGroup::setPixelColor(uint32_t n, uint32_t color)
+  {
+    if (n >= led_count) return;
+    getLedReference(n) = color;
+  }
+
+  void StripGroup::setPixelColor(uint32_t n, uint8_t r, uint8_t g, uint8_t b)
+  {
+    if (n >= led_count) return;
+    getLedReference(n) = {r, g, b};
+  }
+
+  void StripGroup::setPixelColor(uint32_t n, Color color)
+  {
+    if (n >= led_count) return;
+    getLedReference(n) = color;
+  }
+
+  // the first strip is located once, the span then continues strip by strip
+  uint32_t StripGroup::writePixels(uint32_t offset, const LED* src, uint32_t n)
+  {
+    if (strips == nullptr || src == nullptr || offset >= led_count) return 0u;
+    uint32_t done = 0u;
+    for (uint16_t i = locate(offset); i < strip_count && done < n; ++i, offset = 0u)
+    {
+      uint32_t left = n - done;
+      done += strips[i].writePixels(offset, src + done, left > 0xFFFFu ? 0xFFFFu : left);
+    }
+    return done;
+  }
+
+  uint32_t StripGroup::writePixelsRGB(uint32_t offset, const uint8_t* src, uint32_t n, ColorOrder order)
+  {
+    if (strips == nullptr || src == nullptr || offset >= led_count) return 0u;
+    uint8_t size = pgm_read_byte(&__ORDERS[order][3]);
+    uint32_t done = 0u;
+    for (uint16_t i = locate(offset); i < strip_count && done < n; ++i, offset = 0u)
+    {
+      uint32_t left = n - done;
+      done += strips[i].writePixelsRGB(offset, src + done * size, left > 0xFFFFu ? 0xFFFFu : left, order);
+    }
+    return done;
+  }
+
+  uint32_t StripGroup::readPixels(uint32_t offset, LED* dst, uint32_t n) const
+  {
+    if (strips == nullptr || dst == nullptr || offset >= led_count) return 0u;
+    uint32_t done = 0u;
+    for (uint16_t i = locate(offset); i < strip_count && done < n; ++i, offset = 0u)
+    {
+      uint32_t left = n - done;
+      done += strips[i].readPixels(offset, dst + done, left > 0xFFFFu ? 0xFFFFu : left);
+    }
+    return done;
+  }
+
+  LED& StripGroup::getLedReference(uint32_t n) const
+  {
+    uint16_t i = locate(n);
+    if (i >= strip_count) return void_led;
+    strips[i].dirty = true;
+    if (strips[i].reverse) return strips[i].leds[strips[i].count - 1 - n];
+    return strips[i].leds[n];
+  }
+}
+
+// ############################################ WS2812B_HDR_BUFFER ############################################################
+
+namespace WS2812B
+{
+  HDRBuffer::HDRBuffer(LED16* pixels, Strip* strip) 
+  : pixels{pixels}, 
+    strip{strip}, 
+    group{nullptr}, 
+    count{strip ? strip->count : 0u}, 
+    gamma{0} 
+  {}
+
+  HDRBuffer::HDRBuffer(LED16* pixels, StripGroup* group) 
+  : pixels{pixels}, 
+    strip{nullptr}, 
+    group{group}, 
+    count{group ? group->led_count : 0u}, 
+    gamma{0} 
+  {}
+
+  HDRBuffer::HDRBuffer() : HDRBuffer(nullptr, (Strip*)nullptr) {}
+
+  void HDRBuffer::changeConfig(LED16* _pixels, Strip* _strip)
+  {
+    pixels = _pixels;
+    strip = _strip;
+    group = nullptr;
+    count = strip ? strip->count : 0u;
+  }
+
+  void HDRBuffer::changeConfig(LED16* _pixels, StripGroup* _group)
+  {
+    pixels = _pixels;
+    strip = nullptr;
+    group = _group;
+    count = group ? group->led_count : 0u;
+  }
+
+  uint32_t HDRBuffer::numPixels() const
+  {
+    return pixels ? count : 0u;
+  }
+
+  void HDRBuffer::clear()
+  {
+    if (pixels == nullptr) return;
+    memset((uint8_t*)pixels, 0, count * sizeof(LED16));
+  }
+
+  void HDRBuffer::fill(const LED16& color)
+  {
+    if (pixels == nullptr) return;
+    for (uint32_t i = 0; i < count; ++i) pixels[i] = color;
+  }
+
+  void HDRBuffer::fillFromTo(const LED16& color, uint32_t from, uint32_t to)
+  {
+    if (pixels == nullptr || from > to || to >= count) return;
+    for (uint32_t i = from; i <= to; ++i) pixels[i] = color;
+  }
+
+  void HDRBuffer::setPixelColor(uint32_t n, const LED16& color)
+  {
+    if (pixels == nullptr || n >= count) return;
+    pixels[n] = color;
+  }
+
+  void HDRBuffer::setPixelColor(uint32_t n, uint16_t r, uint16_t g, uint16_t b)
+  {
+    setPixelColor(n, LED16(r, g, b));
+  }
+
+  static inline uint16_t qadd16(uint16_t a, uint16_t b)
+  {
+    uint32_t sum = (uint32_t)a + b;
+    return sum > 0xffffu ? 0xffffu : (uint16_t)sum;
+  }
+
+  void HDRBuffer::addPixelColor(uint32_t n, const LED16& color)
+  {
+    if (pixels == nullptr || n >= count) return;
+    pixels[n].r = qadd16(pixels[n].r, color.r);
+    pixels[n].g = qadd16(pixels[n].g, color.g);
+    pixels[n].b = qadd16(pixels[n].b, color.b);
+  }
+
+  LED16 HDRBuffer::getPixelColor(uint32_t n) const
+  {
+    if (pixels == nullptr || n >= count) return LED16();
+    return pixels[n];
+  }
+
+  LED16& HDRBuffer::operator[](uint32_t n)
+  {
+    static LED16 void_pixel;
+    if (pixels == nullptr || n >= count) return void_pixel;
+    return pixels[n];
+  }
+
+  void HDRBuffer::setGamma(bool enable)
+  {
+    gamma = enable;
+  }
+
+  bool HDRBuffer::getGamma() const
+  {
+    return gamma;
+  }
+
+  void HDRBuffer::renderStrip(Strip& s, const LED16* src)
+  {
+    if (s.leds == nullptr) return;
+    if (s.reverse) WS2812B::convert(s.leds + s.count - 1, -1, src, s.count, 255u, gamma);
+    else WS2812B::convert(s.leds, 1, src, s.count, 255u, gamma);
+    s.dirty = true;
+  }
+
+  void HDRBuffer::render()
+  {
+    if (pixels == nullptr) return;
+    if (strip) return renderStrip(*strip, pixels);
+    if (group == nullptr || group->strips == nullptr) return;
+    const LED16* src = pixels;
+    for (uint16_t i = 0; i < group->strip_count; ++i)
+    {
+      renderStrip(group->strips[i], src);
+      src += group->strips[i].count;
+    }
+  }
+
+  void HDRBuffer::show()
+  {
+    render();
+    if (strip) strip->show();
+    else if (group) group->show();
+  }
+}
+
+// ############################################ WS2812B_FRAME_SCHEDULER ########################################################
+
+namespace WS2812B
+{
+  FrameScheduler::FrameScheduler(Strip* strips, uint16_t len, uint16_t fps, bool (*render)(uint32_t)) 
+  : strips{strips}, strip_count{len > 32 ? (uint16_t)32 : len}, group{nullptr}, render{render}, fps{0}, period{0u}, next_due{0u}, started{0},
+  pending{0u}, frame{0u}, frames_rendered{0u}, frames_dropped{0u}, frames_idle{0u}, render_us{0u}, transmit_us{0u}
+  {
+    setFrameRate(fps);
+  }
+
+  FrameScheduler::FrameScheduler(StripGroup* group, uint16_t fps, bool (*render)(uint32_t)) : FrameScheduler((Strip*)nullptr, 0u, fps, render) 
+  {
+    this->group = group;
+  }
+
+  FrameScheduler::FrameScheduler() : FrameScheduler((Strip*)nullptr, 0u, 0u) {}
+
+  void FrameScheduler::setFrameRate(uint16_t f)
+  {
+    fps = f;
+    period = f ? 1000000ul / f : 0u;
+    started = false;
+  }
+
+  uint16_t FrameScheduler::getFrameRate() const
+  {
+    return fps;
+  }
+
+  void FrameScheduler::onRender(bool (*r)(uint32_t))
+  {
+    render = r;
+  }
+
+  /**
+   * A frame whose due time passed by more than one period counts the skipped periods as dropped,
+   * the schedule keeps its phase instead of bursting to catch up.
+   */
+  bool FrameScheduler::tick()
+  {
+    bool rendered = false;
+    uint32_t now = micros();
+    if (!pending && render != nullptr && period && (!started || (int32_t)(now - next_due) >= 0))
+    {
+      if (!started)
+      {
+        next_due = now;
+        started = true;
+      }
+      uint32_t missed = (now - next_due) / period;
+      frames_dropped += missed;
+      next_due += (missed + 1) * period;
+
+      bool changed = render(frame++);
+      render_us = micros() - now;
+      transmit_us = 0u;
+      ++frames_rendered;
+      rendered = true;
+      if (!changed) ++frames_idle;
+      else if (group) pending = 1u;
+      else pending = strip_count == 32 ? 0xFFFFFFFFul : (1ul << strip_count) - 1;
+    }
+    if (pending) send();
+    return rendered;
+  }
+
+  void FrameScheduler::send()
+  {
+    uint32_t t = micros();
+    if (group)
+    {
+      for (uint16_t i = 0; i < group->strip_count; ++i)
+      {
+        if (!group->strips[i].canShow()) return;
+      }
+      group->show();
+      pending = 0u;
+    }
+    else
+    {
+      for (uint16_t i = 0; i < strip_count; ++i)
+      {
+        if (!(pending & (1ul << i)) || !strips[i].canShow()) continue;
+        strips[i].show();
+        pending &= ~(1ul << i);
+      }
+    }
+    transmit_us += micros() - t;
+  }
+
+  bool FrameScheduler::isSending() const
+  {
+    return pending != 0u;
+  }
+
+  uint32_t FrameScheduler::framesRendered() const
+  {
+    return frames_rendered;
+  }
+
+  uint32_t FrameScheduler::framesDropped() const
+  {
+    return frames_dropped;
+  }
+
+  uint32_t FrameScheduler::framesIdle() const
+  {
+    return frames_idle;
+  }
+
+  uint32_t FrameScheduler::renderTime() const
+  {
+    return render_us;
+  }
+
+  uint32_t FrameScheduler::transmitTime() const
+  {
+    return transmit_us;
+  }
+
+  void FrameScheduler::resetStats()
+  {
+    frames_rendered = frames_dropped = frames_idle = 0u;
+    render_us = transmit_us = 0u;
+  }
+}
+
+// ############################################ WS2812B_ANIMATOR ###############################################################
+
+#define WS2812B_TWEEN_ACTIVE 0x80
+#define WS2812B_TWEEN_WRITTEN 0x40
+#define WS2812B_TWEEN_COLOR 0
+#define WS2812B_TWEEN_HUE 1
+#define WS2812B_TWEEN_FADE 2
+
+namespace WS2812B
+{
+  // x * (x + 1) keeps both ends exact: 0 -> 0, 65535 -> 65535
+  uint16_t ease(Easing easing, uint16_t t)
+  {
+    uint32_t x = t;
+    switch (easing)
+    {
+    case EASE_IN_QUAD:
+      return (x * (x + 1)) >> 16;
+    case EASE_OUT_QUAD:
+      x = 65535u - x;
+      return 65535u - ((x * (x + 1)) >> 16);
+    case EASE_IN_OUT_QUAD:
+      if (x < 32768u) return (x * (x + 1)) >> 15;
+      x = 65535u - x;
+      return 65535u - ((x * (x + 1)) >> 15);
+    case EASE_IN_OUT_CUBIC:
+      if (x < 32768u) return (((x * (x + 1)) >> 16) * (x + 1)) >> 14;
+      x = 65535u - x;
+      return 65535u - ((((x * (x + 1)) >> 16) * (x + 1)) >> 14);
+    default:
+      return t;
+    }
+  }
+
+  Animator::Animator(Tween* slots, uint8_t len, Strip* strip) : slots{slots}, slot_count{len}, strip{strip}, group{nullptr} {}
+
+  Animator::Animator(Tween* slots, uint8_t len, StripGroup* group) : slots{slots}, slot_count{len}, strip{nullptr}, group{group} {}
+
+  Animator::Animator() : Animator(nullptr, 0u, (Strip*)nullptr) {}
+
+  // -1 when all slots are running
+  int8_t Animator::add(uint8_t kind, uint16_t from, uint16_t to, uint16_t duration, Easing easing, uint8_t flags)
+  {
+    if (slots == nullptr || from > to) return -1;
+    for (uint8_t i = 0; i < slot_count && i < 128; ++i)
+    {
+      if (slots[i].flags & WS2812B_TWEEN_ACTIVE) continue;
+      Tween& t = slots[i];
+      t.start = millis();
+      t.duration = duration ? duration : 1u;
+      t.from = from;
+      t.to = to;
+      t.kind = kind;
+      t.easing = easing;
+      t.flags = (flags & (TWEEN_LOOP | TWEEN_YOYO)) | WS2812B_TWEEN_ACTIVE;
+      return (int8_t)i;
+    }
+    return -1;
+  }
+
+  int8_t Animator::color(uint16_t from, uint16_t to, const Color& a, const Color& b, uint16_t duration, Easing easing, uint8_t flags)
+  {
+    int8_t id = add(WS2812B_TWEEN_COLOR, from, to, duration, easing, flags);
+    if (id < 0) return id;
+    slots[id].color.a = a;
+    slots[id].color.b = b;
+    return id;
+  }
+
+  int8_t Animator::hue(uint16_t from, uint16_t to, uint16_t hue_start, uint16_t hue_span, uint16_t duration, Easing easing, uint8_t flags, uint8_t sat, uint8_t val)
+  {
+    int8_t id = add(WS2812B_TWEEN_HUE, from, to, duration, easing, flags);
+    if (id < 0) return id;
+    slots[id].hue.start = hue_start;
+    slots[id].hue.span = hue_span;
+    slots[id].hue.sat = sat;
+    slots[id].hue.val = val;
+    return id;
+  }
+
+  int8_t Animator::fade(uint16_t from, uint16_t to, const Color& color, uint8_t level_from, uint8_t level_to, uint16_t duration, Easing easing, uint8_t flags)
+  {
+    int8_t id = add(WS2812B_TWEEN_FADE, from, to, duration, easing, flags);
+    if (id < 0) return id;
+    slots[id].fade.color = color;
+    slots[id].fade.from = level_from;
+    slots[id].fade.to = level_to;
+    return id;
+  }
+
+  void Animator::stop(int8_t id)
+  {
+    if (slots == nullptr || id < 0 || id >= slot_count) return;
+    slots[id].flags = 0;
+  }
+
+  void Animator::stopAll()
+  {
+    for (uint8_t i = 0; slots && i < slot_count; ++i) slots[i].flags = 0;
+  }
+
+  bool Animator::isActive(int8_t id) const
+  {
+    if (slots == nullptr || id < 0 || id >= slot_count) return false;
+    return slots[id].flags & WS2812B_TWEEN_ACTIVE;
+  }
+
+  bool Animator::isAnimating() const
+  {
+    for (uint8_t i = 0; slots && i < slot_count; ++i)
+    {
+      if (slots[i].flags & WS2812B_TWEEN_ACTIVE) return true;
+    }
+    return false;
+  }
+
+  Color Animator::evaluate(const Tween& t, uint16_t p) const
+  {
+    switch (t.kind)
+    {
+    case WS2812B_TWEEN_HUE:
+      return WS2812B::hsv(t.hue.start + (uint16_t)(((uint32_t)t.hue.span * p) >> 16), t.hue.sat, t.hue.val);
+    case WS2812B_TWEEN_FADE:
+      return scale8(t.fade.color, lerp8(t.fade.from, t.fade.to, p >> 8));
+    default:
+      return blend(t.color.a, t.color.b, p >> 8);
+    }
+  }
+
+  void Animator::draw(const Color& color, uint16_t from, uint16_t to)
+  {
+    if (strip) strip->fillFromTo(color, from, to);
+    else if (group) group->fillFromTo(color, from, to);
+  }
+
+  bool Animator::update()
+  {
+    return update(millis());
+  }
+
+  bool Animator::update(uint32_t now)
+  {
+    bool changed = false;
+    for (uint8_t i = 0; slots && i < slot_count; ++i)
+    {
+      Tween& t = slots[i];
+      if (!(t.flags & WS2812B_TWEEN_ACTIVE)) continue;
+
+      uint32_t elapsed = now - t.start;
+      bool backwards = false;
+      if (elapsed >= t.duration)
+      {
+        if (t.flags & (TWEEN_LOOP | TWEEN_YOYO))
+        {
+          uint32_t periods = elapsed / t.duration;
+          if (t.flags & TWEEN_YOYO) backwards = periods & 1;
+          elapsed -= periods * t.duration;
+        }
+        else
+        {
+          elapsed = t.duration;
+          t.flags &= ~WS2812B_TWEEN_ACTIVE; // last value is still drawn below
+        }
+      }
+
+      uint16_t linear = (uint16_t)((elapsed * 65535u) / t.duration);
+      if (backwards) linear = 65535u - linear;
+      uint16_t p = ease(t.easing, linear);
+
+      if ((t.flags & WS2812B_TWEEN_WRITTEN) && p == t.last) continue;
+      t.last = p;
+      t.flags |= WS2812B_TWEEN_WRITTEN;
+      draw(evaluate(t, p), t.from, t.to);
+      changed = true;
+    }
+    return changed;
   }
 }
 
 // ###################################################  WS2812B_Rect ##########################################################################
 
-// namespace WS2812B
-// {
-//   Pos::Pos(int16_t x, int16_t y) : x{x}, y{y} {}
-//   Pos::Pos() : Pos(0, 0) {}
-
-//   Size::Size(uint16_t w, uint16_t h) : w{w}, h{h} {}
-//   Size::Size() : Size(0u, 0u) {}
-
-//   Rect::Rect() : is_begin{0}, pin{255}, dim{0u, 0u}, led_matrix{nullptr}, led_count{0u} {}
-//   Rect::Rect(LED* matrix, uint16_t w, uint16_t h, uint8_t p, connection_t connection) : bright{255}, is_begin{0}, pin{p}, x_ori{NORMAL}, y_ori{NORMAL}, dim{w, h}, led_matrix{matrix}, led_count{0u}, con{connection}
-//   {
-//     calcLedCount();
-//   }
-
-//   bool Rect::begin()
-//   {
-//     is_begin = WS2812B::begin(pin);
-//     return is_begin;
-//   }
-
-//   void Rect::setConnectionType(Rect::connection_t connection)
-//   {
-//     con = connection;
-//   }
-
-//   Rect::connection_t Rect::getConnectionType() const
-//   {
-//     return con;
-//   }
-
-//   void Rect::changeLEDsConfig(LED* matrix, uint16_t width, uint16_t height)
-//   {
-//     led_matrix = matrix;
-//     dim.w = width;
-//     dim.h = height;
-//   }
-
-//   void Rect::setXOrientation(Rect::orientation_t orientation)
-//   {
-//     x_ori = orientation;
-//   }
-
-//   void Rect::setYOrientation(Rect::orientation_t orientation)
-//   {
-//     y_ori = orientation;
-//   }
-
-//   Rect::orientation_t Rect::getXOrientation() const
-//   {
-//     return x_ori;
-//   }
-
-//   Rect::orientation_t Rect::getYOrientation() const
-//   {
-//     return y_ori;
-//   }
-
-//   uint16_t Rect::getWidth() const
-//   {
-//     return dim.w;
-//   }
-
-//   uint16_t Rect::getHeight() const
-//   {
-//     return dim.h;
-//   }
-
-//   uint16_t Rect::numLeds() const
-//   {
-//     return led_count;
-//   }
-
-//   void Rect::calcLedCount()
-//   {
-//     led_count = uint16_t(dim.w * dim.h);
-//   }
-
-//   LED& Rect::operator[](Pos pos)
-//   {
-//     if (pos.x >= dim.w || pos.x < 0 || pos.y >= dim.h || pos.y < 0) return void_led;
-//     if (x_ori == REVERSE) pos.x = dim.w - 1 - pos.x;
-//     if (y_ori == REVERSE) pos.y = dim.h - 1 - pos.y;
-//     switch (con)
-//     {
-//     case LINEAR:
-//       return led_matrix[pos.x * dim.h + ((pos.x & 1) == 0 ? pos.y : dim.h - 1 - pos.y)];
-//     case CROSS:
-//       return led_matrix[pos.x * dim.h + pos.y];
-//     default:
-//       break;
-//     }
-//     return led_matrix[0];
-//   }
-
-//   LED& Rect::operator[](uint16_t i)
-//   {
-//     if (i >= led_count) return void_led;
-//     return led_matrix[i];
-//   }
-
-//   void Rect::fill(uint32_t c)
-//   {
-//     WS2812B::fill(led_matrix, led_count, c);
-//   }
-
-//   void Rect::fill(uint8_t r, uint8_t g, uint8_t b)
-//   {
-//     WS2812B::fill(led_matrix, led_count, r, g, b);
-//   }
-
-//   void Rect::fill(const Color& c)
-//   {
-//     WS2812B::fill(led_matrix, led_count, c);
-//   }
-
-//   void Rect::clear()
-//   {
-//     WS2812B::clear(led_matrix, led_count);
-//   }
-
-//   void Rect::show()
-//   {
-//     if (!is_begin) return;
-//     WS2812B::show(led_matrix, led_count, pin, bright);
-//   }
-
-//   void Rect::drawRectangle(Pos pos, Size size, uint32_t color, bool fill)
-//   {
-//     if (pos.x >= (int16_t)dim.w || pos.y >= (int16_t)dim.h || size.w < 1 || size.h < 1) return;
-    
-//     if (fill)
-//     {
-//       for (int16_t i = 0; i < size.h; ++i)
-//         for (int16_t j = 0; j < size.w; ++j)
-//           this->operator[]({pos.x + j, pos.y + i}) = color;
-//     }
-//     else
-//     {
-//       for (int16_t i = 0; i < size.w; ++i)
-//       {
-//         this->operator[]({pos.x + i, pos.y}) = color;
-//         this->operator[]({pos.x + i, pos.y + size.h - 1}) = color;
-//       }
-
-//       for (int16_t i = 0; i < size.h; ++i)
-//       {
-//         this->operator[]({pos.x, pos.y + i}) = color;
-//         this->operator[]({pos.x + size.w - 1, pos.y + i}) = color;
-//       }
-//     }
-//   }
-
-//   void Rect::drawRectangle(Pos pos, uint16_t width, uint16_t height, uint32_t color, bool fill)
-//   {
-//     return drawRectangle(pos, {width, height}, color, fill);
-//   }
-
-//   void Rect::drawRectangle(int16_t x, int16_t y, Size size, uint32_t color, bool fill)
-//   {
-//     return drawRectangle({x, y}, size, color, fill);
-//   }
-
-//   void Rect::drawRectangle(int16_t x, int16_t y, uint16_t w, uint16_t h, uint32_t color, bool fill)
-//   {
-//     return drawRectangle({x, y}, {w, h}, color, fill);
-//   }
-
-//   void Rect::drawLine(Pos begin, Pos end, uint32_t color)
-//   {
-//     int16_t dx = abs(end.x - begin.x);
-//     int16_t dy = abs(end.y - begin.y);
-//     int16_t sx = (begin.x < end.x) ? 1 : -1;
-//     int16_t sy = (begin.y < end.y) ? 1 : -1;
-//     int16_t err = dx - dy;
-
-//     while (true)
-//     {
-//       this->operator[](begin) = color;
-
-//       if (begin.x == end.x && begin.y == end.y) break;
-
-//       int16_t e2 = 2 * err;
-
-//       if (e2 > -dy) 
-//       {
-//         err -= dy;
-//         begin.x += sx;
-//       }
-
-//       if (e2 < dx)
-//       {
-//         err += dx;
-//         begin.y += sy;
-//       }
-//     }
-//   }
-
-//   void Rect::drawLine(int16_t x0, int16_t y0, Pos end, uint32_t color)
-//   {
-//     return drawLine({x0, y0}, end, color);
-//   }
-
-//   void Rect::drawLine(Pos begin, int16_t x1, int16_t y1, uint32_t color)
-//   {
-//     return drawLine(begin, {x1, y1}, color);
-//   }
-
-//   void Rect::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t color)
-//   {
-//     return drawLine({x0, y0}, {x1, y1}, color);
-//   }
-
-//   void Rect::drawCircle(Pos center, uint16_t r, uint32_t color, bool fill)
-//   {
-//     int16_t x = 0;
-//     int16_t y = r;
-//     int16_t d = 1 - r;
-
-//     while (y >= x)
-//     {
-//       if (fill)
-//       {
-//         for (int16_t i = -x; i <= x; ++i)
-//         {
-//           this->operator[]({center.x + i, center.y + y}) = color;
-//           this->operator[]({center.x + i, center.y - y}) = color;
-//         }
-//         for (int16_t i = -y; i <= y; ++i)
-//         {
-//           this->operator[]({center.x + i, center.y + x}) = color;
-//           this->operator[]({center.x + i, center.y - x}) = color;
-//         }
-//       }
-//       else
-//       {
-//         this->operator[]({center.x + x, center.y + y}) = color;
-//         this->operator[]({center.x - x, center.y + y}) = color;
-//         this->operator[]({center.x + x, center.y - y}) = color;
-//         this->operator[]({center.x - x, center.y - y}) = color;
-//         this->operator[]({center.x + y, center.y + x}) = color;
-//         this->operator[]({center.x - y, center.y + x}) = color;
-//         this->operator[]({center.x + y, center.y - x}) = color;
-//         this->operator[]({center.x - y, center.y - x}) = color;
-//       }
-
-//       ++x;
-
-//       if (d >= 0)
-//       {
-//         --y;
-//         d = d + 2 * (x - y) + 1;
-//       }
-//       else
-//       {
-//         d = d + 2 * x + 1;
-//       }
-//     }
-//   }
-
-//   void Rect::drawCircle(int16_t x_center, int16_t y_center, uint16_t r, uint32_t color, bool fill)
-//   {
-//     return drawCircle({x_center, y_center}, r, color, fill);
-//   }
-// }
\ No newline at end of file
+namespace WS2812B
+{
+  Pos::Pos(int16_t x, int16_t y) : x{x}, y{y} {}
+  Pos::Pos() : Pos(0, 0) {}
+
+  Size::Size(uint16_t w, uint16_t h) : w{w}, h{h} {}
+  Size::Size() : Size(0u, 0u) {}
+
+  Rect::Rect() : Rect(nullptr, 0u, 0u, 255u) {}
+
+  Rect::Rect(LED* matrix, uint16_t w, uint16_t h, uint8_t p, connection_t connection) 
+  : bright{255}, is_begin{0}, own{matrix, uint16_t(w * h), p}, tiles{nullptr}, tiles_x{1}, tiles_y{1}, tile{w, h}, 
+  x_ori{NORMAL}, y_ori{NORMAL}, dim{w, h}, led_count{0u}, con{connection}, xy_table{nullptr}, xy_table_P{nullptr}
+  {
+    calcLedCount();
+  }
+
+  Rect::Rect(Strip* strips, uint8_t tx, uint8_t ty, uint16_t tw, uint16_t th, connection_t connection) 
+  : bright{255}, is_begin{0}, own{}, tiles{strips}, tiles_x{tx}, tiles_y{ty}, tile{tw, th}, 
+  x_ori{NORMAL}, y_ori{NORMAL}, dim{uint16_t(tx * tw), uint16_t(ty * th)}, led_count{0u}, con{connection}, xy_table{nullptr}, xy_table_P{nullptr}
+  {
+    calcLedCount();
+  }
+
+  bool Rect::begin()
+  {
+    is_begin = true;
+    for (uint16_t i = 0; i < tileCount(); ++i) is_begin = tileAt(i).begin() && is_begin;
+    buildTable();
+    return is_begin;
+  }
+
+  void Rect::changeLEDsConfig(LED* matrix, uint16_t width, uint16_t height)
+  {
+    tiles = nullptr;
+    tiles_x = tiles_y = 1;
+    own.changeLEDsConfig(matrix, uint16_t(width * height));
+    tile = dim = {width, height};
+    calcLedCount();
+    buildTable();
+  }
+
+  void Rect::setXYTable(LED** table)
+  {
+    xy_table = table;
+    buildTable();
+  }
+
+  void Rect::setXYTable_P(const uint16_t* table)
+  {
+    xy_table_P = table;
+  }
+
+  void Rect::setConnectionType(Rect::connection_t connection)
+  {
+    con = connection;
+    buildTable();
+  }
+
+  Rect::connection_t Rect::getConnectionType() const
+  {
+    return con;
+  }
+
+  void Rect::setXOrientation(Rect::orientation_t orientation)
+  {
+    x_ori = orientation;
+    buildTable();
+  }
+
+  void Rect::setYOrientation(Rect::orientation_t orientation)
+  {
+    y_ori = orientation;
+    buildTable();
+  }
+
+  Rect::orientation_t Rect::getXOrientation() const
+  {
+    return x_ori;
+  }
+
+  Rect::orientation_t Rect::getYOrientation() const
+  {
+    return y_ori;
+  }
+
+  uint16_t Rect::getWidth() const
+  {
+    return dim.w;
+  }
+
+  uint16_t Rect::getHeight() const
+  {
+    return dim.h;
+  }
+
+  uint16_t Rect::numLeds() const
+  {
+    return led_count;
+  }
+
+  void Rect::calcLedCount()
+  {
+    led_count = uint16_t(dim.w * dim.h);
+  }
+
+  uint16_t Rect::tileCount() const
+  {
+    return uint16_t(tiles_x * tiles_y);
+  }
+
+  Strip& Rect::tileAt(uint16_t i)
+  {
+    return tiles == nullptr ? own : tiles[i];
+  }
+
+  void Rect::touch()
+  {
+    for (uint16_t i = 0; i < tileCount(); ++i) tileAt(i).dirty = true;
+  }
+
+  // the table caches mapLed() for every (x, y), it only has to follow the geometry
+  void Rect::buildTable()
+  {
+    if (xy_table == nullptr || !is_begin) return;
+    for (uint16_t y = 0; y < dim.h; ++y)
+      for (uint16_t x = 0; x < dim.w; ++x)
+        xy_table[y * dim.w + x] = mapLed(x, y);
+  }
+
+  LED* Rect::mapLed(int16_t x, int16_t y)
+  {
+    if (x_ori == REVERSE) x = dim.w - 1 - x;
+    if (y_ori == REVERSE) y = dim.h - 1 - y;
+    uint8_t tx = tiles_x > 1 ? x / tile.w : 0;
+    uint8_t ty = tiles_y > 1 ? y / tile.h : 0;
+    LED* leds = tileAt(ty * tiles_x + tx).leds;
+    if (leds == nullptr) return nullptr;
+    return leds + index(x - tx * tile.w, y - ty * tile.h, tile.h, con);
+  }
+
+  LED* Rect::ledAtIndex(uint16_t i)
+  {
+    uint16_t tile_leds = uint16_t(tile.w * tile.h);
+    uint16_t t = tileCount() > 1 ? i / tile_leds : 0;
+    LED* leds = tileAt(t).leds;
+    return leds == nullptr ? nullptr : leds + (i - t * tile_leds);
+  }
+
+  LED* Rect::ledAt(int16_t x, int16_t y)
+  {
+    if (x >= (int16_t)dim.w || x < 0 || y >= (int16_t)dim.h || y < 0) return nullptr;
+    if (xy_table != nullptr && is_begin) return xy_table[y * dim.w + x];
+    if (xy_table_P != nullptr) return ledAtIndex(pgm_read_word(&xy_table_P[y * dim.w + x]));
+    return mapLed(x, y);
+  }
+
+  // a column is stored as one run of LEDs in each tile it crosses, whatever the connection and orientation
+  void Rect::fillColumn(int16_t x, int16_t y0, int16_t y1, const Color& color)
+  {
+    if (y0 > y1)
+    {
+      int16_t t = y0;
+      y0 = y1;
+      y1 = t;
+    }
+    if (x < 0 || x >= (int16_t)dim.w || y1 < 0 || y0 >= (int16_t)dim.h) return;
+    if (y0 < 0) y0 = 0;
+    if (y1 >= (int16_t)dim.h) y1 = dim.h - 1;
+
+    // a PROGMEM table may describe any wiring, so it is followed pixel by pixel
+    if (xy_table_P != nullptr)
+    {
+      for (int16_t y = y0; y <= y1; ++y)
+      {
+        LED* led = ledAt(x, y);
+        if (led) *led = color;
+      }
+      return;
+    }
+
+    if (x_ori == REVERSE) x = dim.w - 1 - x;
+    if (y_ori == REVERSE)
+    {
+      int16_t t = y0;
+      y0 = dim.h - 1 - y1;
+      y1 = dim.h - 1 - t;
+    }
+    uint8_t tx = tiles_x > 1 ? x / tile.w : 0;
+    uint16_t lx = x - tx * tile.w;
+    while (y0 <= y1)
+    {
+      uint8_t ty = tiles_y > 1 ? y0 / tile.h : 0;
+      uint16_t a = y0 - ty * tile.h;
+      uint16_t b = y1 - ty * tile.h < tile.h ? y1 - ty * tile.h : tile.h - 1;
+      LED* leds = tileAt(ty * tiles_x + tx).leds;
+      if (leds != nullptr)
+      {
+        uint16_t first = (con == LINEAR && (lx & 1)) ? lx * tile.h + tile.h - 1 - b : lx * tile.h + a;
+        WS2812B::fill(leds + first, b - a + 1, color);
+      }
+      y0 += b - a + 1;
+    }
+  }
+
+  void Rect::fillRow(int16_t y, int16_t x0, int16_t x1, const Color& color)
+  {
+    if (x0 > x1)
+    {
+      int16_t t = x0;
+      x0 = x1;
+      x1 = t;
+    }
+    if (x0 < 0) x0 = 0;
+    if (x1 >= (int16_t)dim.w) x1 = dim.w - 1;
+    for (int16_t x = x0; x <= x1; ++x)
+    {
+      LED* led = ledAt(x, y);
+      if (led) *led = color;
+    }
+  }
+
+  LED& Rect::operator[](Pos pos)
+  {
+    LED* led = ledAt(pos.x, pos.y);
+    if (led == nullptr) return void_led;
+    touch();
+    return *led;
+  }
+
+  LED& Rect::operator[](uint16_t i)
+  {
+    if (i >= led_count) return void_led;
+    LED* led = ledAtIndex(i);
+    if (led == nullptr) return void_led;
+    touch();
+    return *led;
+  }
+
+  void Rect::fill(uint32_t c)
+  {
+    fill(Color{c});
+  }
+
+  void Rect::fill(uint8_t r, uint8_t g, uint8_t b)
+  {
+    fill(Color{r, g, b});
+  }
+
+  void Rect::fill(const Color& c)
+  {
+    for (uint16_t i = 0; i < tileCount(); ++i) tileAt(i).fill(c);
+  }
+
+  void Rect::clear()
+  {
+    for (uint16_t i = 0; i < tileCount(); ++i) tileAt(i).clear();
+  }
+
+  void Rect::show()
+  {
+    if (!is_begin) return;
+    for (uint16_t i = 0; i < tileCount(); ++i)
+    {
+      tileAt(i).bright = bright;
+      tileAt(i).show();
+    }
+  }
+
+  void Rect::drawPixel(int16_t x, int16_t y, uint32_t color)
+  {
+    LED* led = ledAt(x, y);
+    if (led == nullptr) return;
+    *led = color;
+    touch();
+  }
+
+  void Rect::drawRectangle(Pos pos, Size size, uint32_t color, bool fill)
+  {
+    if (pos.x >= (int16_t)dim.w || pos.y >= (int16_t)dim.h || size.w < 1 || size.h < 1) return;
+    Color c{color};
+    int16_t right = pos.x + size.w - 1;
+    int16_t bottom = pos.y + size.h - 1;
+
+    if (fill)
+    {
+      for (int16_t x = pos.x < 0 ? 0 : pos.x; x <= right && x < (int16_t)dim.w; ++x) fillColumn(x, pos.y, bottom, c);
+    }
+    else
+    {
+      fillColumn(pos.x, pos.y, bottom, c);
+      fillColumn(right, pos.y, bottom, c);
+      fillRow(pos.y, pos.x, right, c);
+      fillRow(bottom, pos.x, right, c);
+    }
+    touch();
+  }
+
+  void Rect::drawRectangle(Pos pos, uint16_t width, uint16_t height, uint32_t color, bool fill)
+  {
+    return drawRectangle(pos, {width, height}, color, fill);
+  }
+
+  void Rect::drawRectangle(int16_t x, int16_t y, Size size, uint32_t color, bool fill)
+  {
+    return drawRectangle({x, y}, size, color, fill);
+  }
+
+  void Rect::drawRectangle(int16_t x, int16_t y, uint16_t w, uint16_t h, uint32_t color, bool fill)
+  {
+    return drawRectangle({x, y}, {w, h}, color, fill);
+  }
+
+  void Rect::drawLine(Pos begin, Pos end, uint32_t color)
+  {
+    Color c{color};
+    if (begin.x == end.x)
+    {
+      fillColumn(begin.x, begin.y, end.y, c);
+      touch();
+      return;
+    }
+
+    int16_t dx = abs(end.x - begin.x);
+    int16_t dy = abs(end.y - begin.y);
+    int16_t sx = (begin.x < end.x) ? 1 : -1;
+    int16_t sy = (begin.y < end.y) ? 1 : -1;
+    int16_t err = dx - dy;
+
+    while (true)
+    {
+      LED* led = ledAt(begin.x, begin.y);
+      if (led) *led = c;
+
+      if (begin.x == end.x && begin.y == end.y) break;
+
+      int16_t e2 = 2 * err;
+
+      if (e2 > -dy) 
+      {
+        err -= dy;
+        begin.x += sx;
+      }
+
+      if (e2 < dx)
+      {
+        err += dx;
+        begin.y += sy;
+      }
+    }
+    touch();
+  }
+
+  void Rect::drawLine(int16_t x0, int16_t y0, Pos end, uint32_t color)
+  {
+    return drawLine({x0, y0}, end, color);
+  }
+
+  void Rect::drawLine(Pos begin, int16_t x1, int16_t y1, uint32_t color)
+  {
+    return drawLine(begin, {x1, y1}, color);
+  }
+
+  void Rect::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t color)
+  {
+    return drawLine({x0, y0}, {x1, y1}, color);
+  }
+
+  void Rect::drawCircle(Pos center, uint16_t r, uint32_t color, bool fill)
+  {
+    Color c{color};
+    int16_t x = 0;
+    int16_t y = r;
+    int16_t d = 1 - r;
+
+    while (y >= x)
+    {
+      if (fill)
+      {
+        fillColumn(center.x + x, center.y - y, center.y + y, c);
+        fillColumn(center.x - x, center.y - y, center.y + y, c);
+        fillColumn(center.x + y, center.y - x, center.y + x, c);
+        fillColumn(center.x - y, center.y - x, center.y + x, c);
+      }
+      else
+      {
+        const Pos points[8] = {
+          {int16_t(center.x + x), int16_t(center.y + y)}, {int16_t(center.x - x), int16_t(center.y + y)},
+          {int16_t(center.x + x), int16_t(center.y - y)}, {int16_t(center.x - x), int16_t(center.y - y)},
+          {int16_t(center.x + y), int16_t(center.y + x)}, {int16_t(center.x - y), int16_t(center.y + x)},
+          {int16_t(center.x + y), int16_t(center.y - x)}, {int16_t(center.x - y), int16_t(center.y - x)}
+        };
+        for (uint8_t i = 0; i < 8; ++i)
+        {
+          LED* led = ledAt(points[i].x, points[i].y);
+          if (led) *led = c;
+        }
+      }
+
+      ++x;
+
+      if (d >= 0)
+      {
+        --y;
+        d = d + 2 * (x - y) + 1;
+      }
+      else
+      {
+        d = d + 2 * x + 1;
+      }
+    }
+    touch();
+  }
+
+  void Rect::drawCircle(int16_t x_center, int16_t y_center, uint16_t r, uint32_t color, bool fill)
+  {
+    return drawCircle({x_center, y_center}, r, color, fill);
+  }
+}
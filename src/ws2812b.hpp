@@ -1,5 +1,27 @@
 #pragma once
+#ifdef WS2812B_HOST
+#include "host.hpp"
+#else
 #include <Arduino.h>
+#endif
+
+#define WS2812B_PARALLEL_MAX 8
+// bytes of the StripGroup parallel buffer for strips of up to LEDS LEDs: one port value per bit + 1 read ahead
+#define WS2812B_PARALLEL_BUFFER(LEDS) ((LEDS) * 24u + 1u)
+
+// pins whose latch time the free show() functions remember, the least recently sent one is reused
+#ifndef WS2812B_PIN_TIMERS
+#define WS2812B_PIN_TIMERS 8
+#endif
+
+#ifndef WS2812B_COMPOSITE_BLOCK
+#define WS2812B_COMPOSITE_BLOCK 32
+#endif
+
+// 1 enables temporal dithering in OutputStage, 0 leaves it out of the build completely (set it for the whole build, e.g. -DWS2812B_DITHER=1)
+#ifndef WS2812B_DITHER
+#define WS2812B_DITHER 0
+#endif
 
 
 static const uint8_t PROGMEM __GAMMA8_TABLE[256] = 
@@ -31,6 +53,7 @@ namespace WS2812B
     LED(uint32_t color);
     LED(uint8_t r, uint8_t g, uint8_t b);
     LED();
+    LED(const LED& other) = default;
     uint8_t g;
     uint8_t r;
     uint8_t b;
@@ -48,6 +71,19 @@ namespace WS2812B
 
   using Color = LED;
 
+  template <typename T>
+  struct Pixel
+  {
+    Pixel() : r{0}, g{0}, b{0} {}
+    Pixel(T r, T g, T b) : r{r}, g{g}, b{b} {}
+    T r;
+    T g;
+    T b;
+  };
+
+  using LED16 = Pixel<uint16_t>;
+
+  // false for pin 255, and on ESP32 when all WS2812B_RMT_CHANNELS channels are taken by other pins
   bool begin(uint8_t pin);
 
   Color& gamma32(Color& color);
@@ -69,10 +105,332 @@ namespace WS2812B
 
   LED hsv(uint16_t hue, uint8_t sat = 255u, uint8_t val = 255u);
 
+  // saturation and value of an hsv conversion, the constant channels are scaled once
+  struct HSVScale
+  {
+    HSVScale(uint8_t sat, uint8_t val);
+    uint8_t apply(uint8_t c) const; // c * sat + (255 - sat), then * val; never above 255
+    uint8_t sat;
+    uint8_t val;
+    uint8_t lo;
+    uint8_t hi;
+  };
+
+  /**
+   * Walks the hue circle with a fixed step, every next() is a few adds, a table lookup and the
+   * two sat/val scalings of the changing channels, instead of the multiply and division of hsv().
+   * Step is in hsv() hue units, it may be negative.
+   */
+  class HSVStepper
+  {
+  public:
+    HSVStepper(uint16_t hue, int16_t step, uint8_t sat = 255u, uint8_t val = 255u);
+    void setHue(uint16_t hue);
+    void setStep(int16_t step);
+    void setSaturation(uint8_t sat);
+    void setValue(uint8_t val);
+    uint8_t getSaturation() const;
+    uint8_t getValue() const;
+    Color next();
+    void fill(LED* leds, uint16_t len);
+
+  private:
+    uint8_t sector;
+    uint16_t pos;
+    uint8_t step_sectors;
+    uint16_t step_pos;
+    HSVScale scale;
+  };
+
+  void fillRainbow(LED* leds, uint16_t len, uint16_t start_hue, int16_t delta_hue, uint8_t sat = 255u, uint8_t val = 255u);
+
+  // hue goes the shorter way around the circle
+  void fillGradientHSV(LED* leds, uint16_t len, uint16_t hue_from, uint16_t hue_to, uint8_t sat = 255u, uint8_t val = 255u);
+
+  void fillGradientRGB(LED* leds, uint16_t len, const Color& from, const Color& to);
+
+  /**
+   * 16 entry gradient palettes. Constant palettes stay in flash as uint32_t[16] PROGMEM (0xRRGGBB),
+   * functions taking them end with _P. Palette16 is a RAM copy (48 bytes) that can fade toward
+   * another palette a little every frame. An 8-bit index selects entry index >> 4, the low 4 bits
+   * blend it with the next entry (the last one blends back into the first).
+   */
+  struct Palette16
+  {
+    Palette16();
+    void load_P(const uint32_t* palette);
+    bool fadeToward(const Palette16& target, uint8_t step = 8u);
+    bool fadeToward_P(const uint32_t* palette, uint8_t step = 8u);
+    Color get(uint8_t index, uint8_t bright = 255u, bool blend = true) const;
+    LED entries[16];
+  };
+
+  extern const uint32_t PALETTE_RAINBOW[16] PROGMEM;
+  extern const uint32_t PALETTE_PARTY[16] PROGMEM;
+  extern const uint32_t PALETTE_HEAT[16] PROGMEM;
+  extern const uint32_t PALETTE_LAVA[16] PROGMEM;
+  extern const uint32_t PALETTE_OCEAN[16] PROGMEM;
+  extern const uint32_t PALETTE_FOREST[16] PROGMEM;
+
+  Color colorFromPalette_P(const uint32_t* palette, uint8_t index, uint8_t bright = 255u, bool blend = true);
+
+  void fillFromPalette(LED* leds, uint16_t len, const Palette16& palette, uint8_t start_index, uint8_t step, uint8_t bright = 255u, bool blend = true);
+
+  void fillFromPalette_P(LED* leds, uint16_t len, const uint32_t* palette, uint8_t start_index, uint8_t step, uint8_t bright = 255u, bool blend = true);
+
+  enum BlendMode : uint8_t
+  {
+    BLEND_ALPHA, // source over destination
+    BLEND_ADD, // saturating, alpha scales the source
+    BLEND_MULTIPLY,
+    BLEND_SCREEN,
+    BLEND_MAX
+  };
+
+  // source buffer drawn over LEDs offset - offset + len - 1 of the target
+  struct Layer
+  {
+    Layer();
+    Layer(const LED* leds, uint16_t len, uint16_t offset = 0u, BlendMode mode = BLEND_ALPHA, uint8_t alpha = 255u);
+    const LED* leds;
+    uint16_t len;
+    uint16_t offset;
+    BlendMode mode;
+    uint8_t alpha; // 0 - layer is skipped
+  };
+
+  /**
+   * Blends layers, in order, into leds in place. The target is walked once in blocks of
+   * WS2812B_COMPOSITE_BLOCK LEDs and every layer touches only the blocks it covers,
+   * no temporary buffer is used.
+   */
+  void composite(LED* leds, uint16_t len, const Layer* layers, uint8_t count);
+
+  void convert(LED* dst, const LED16* src, uint16_t len, uint8_t bright = 255u, bool gamma = false);
+
   void show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright = 255);
 
+  void waitShowDone();
+
+  void waitShowDone(uint8_t pin);
+
+  /**
+   * callback gets the pin after its frame left the wire. On ESP32 it is called from the RMT
+   * interrupt: keep it short, in IRAM (IRAM_ATTR), and don't block, allocate or print in it.
+   */
+  void onShowDone(void (*callback)(uint8_t pin));
+
+  void transpose8(const uint8_t* values, const uint8_t* masks, uint8_t n, uint8_t base, uint8_t* out);
+
+  /**
+   * Stages a parallel frame of n strips: bytes of every strip scaled by bright and transposed
+   * into one port value per bit (masks[s] set for a 1 of strip s), followed by one 0 value the
+   * transmit loop reads ahead. Strips shorter than the longest get 0 bits (black) at the end.
+   * Returns the number of bit values, 0 when they don't fit in size.
+   */
+  uint16_t transposeFrame(const uint8_t* const* bytes, const uint16_t* lens, const uint8_t* masks, uint8_t n, uint8_t bright, uint8_t* out, uint16_t size);
+
+  // latch timer of pin for show() without a Strip
+  uint32_t& pinTimer(uint8_t pin);
+
+  // repeats one pixel of size bytes count times
+  void fillBytes(void* dst, uint16_t count, const void* pixel, uint8_t size);
+
+  void _extern_timer_show(LED* leds, uint16_t len, uint8_t pin, uint8_t bright, uint32_t& timer);
+  void _extern_timer_show_raw(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint32_t& timer);
+  void _extern_timer_show_bytes(const uint8_t* bytes, uint16_t num_bytes, uint8_t pin, uint8_t bright, uint32_t& timer);
+  // true when the previous frame on pin is off the wire and its latch has expired
+  bool _extern_can_show(uint8_t pin, uint32_t timer);
+  // claims what the backend needs to send on pin (ESP32: an RMT channel)
+  bool _extern_begin(uint8_t pin);
+
+  enum ColorOrder : uint8_t
+  {
+    GRB,
+    RGB,
+    BRG,
+    RBG,
+    GBR,
+    BGR,
+    GRBW,
+    RGBW
+  };
+
+  // byte offsets of the channels on the wire, the white channel of 4 byte layouts is sent last
+  template <ColorOrder O>
+  struct Layout;
+
+#define WS2812B_LAYOUT(O, R, G, B, SIZE) \
+  template <> \
+  struct Layout<O> \
+  { \
+    static constexpr uint8_t r = R; \
+    static constexpr uint8_t g = G; \
+    static constexpr uint8_t b = B; \
+    static constexpr uint8_t size = SIZE; \
+  };
+
+  WS2812B_LAYOUT(GRB, 1, 0, 2, 3)
+  WS2812B_LAYOUT(RGB, 0, 1, 2, 3)
+  WS2812B_LAYOUT(BRG, 1, 2, 0, 3)
+  WS2812B_LAYOUT(RBG, 0, 2, 1, 3)
+  WS2812B_LAYOUT(GBR, 2, 0, 1, 3)
+  WS2812B_LAYOUT(BGR, 2, 1, 0, 3)
+  WS2812B_LAYOUT(GRBW, 1, 0, 2, 4)
+  WS2812B_LAYOUT(RGBW, 0, 1, 2, 4)
+
+#undef WS2812B_LAYOUT
+
+  /**
+   * Pixel stored in the wire order of its chip, so the buffer is sent as it is.
+   * Colors are set in RGB; on RGBW layouts the part shared by r, g and b goes to the white channel.
+   */
+  template <ColorOrder O>
+  struct __attribute__((packed)) OrderedLED
+  {
+    using layout = Layout<O>;
+
+    OrderedLED() : bytes{} {}
+    OrderedLED(uint32_t color) { set((uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color); }
+    OrderedLED(uint8_t r, uint8_t g, uint8_t b) { set(r, g, b); }
+    explicit OrderedLED(const LED& color) { set(color.r, color.g, color.b); }
+
+    void set(uint8_t r, uint8_t g, uint8_t b)
+    {
+      uint8_t w = 0;
+      if (layout::size == 4)
+      {
+        w = r < g ? r : g;
+        if (b < w) w = b;
+        bytes[layout::size - 1] = w;
+      }
+      bytes[layout::r] = r - w;
+      bytes[layout::g] = g - w;
+      bytes[layout::b] = b - w;
+    }
+
+    // 3 byte layouts mix the white into r, g and b
+    void setRGBW(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+      if (layout::size == 4)
+      {
+        bytes[layout::r] = r;
+        bytes[layout::g] = g;
+        bytes[layout::b] = b;
+        bytes[layout::size - 1] = w;
+      }
+      else set(add(r, w), add(g, w), add(b, w));
+    }
+
+    uint8_t red() const { return bytes[layout::r]; }
+    uint8_t green() const { return bytes[layout::g]; }
+    uint8_t blue() const { return bytes[layout::b]; }
+    uint8_t white() const { return layout::size == 4 ? bytes[layout::size - 1] : 0; }
+
+    operator LED() const { return LED(add(red(), white()), add(green(), white()), add(blue(), white())); }
+
+    uint8_t bytes[layout::size];
+
+  private:
+    static uint8_t add(uint8_t a, uint8_t b) { return a + b > 255 ? 255 : a + b; }
+  };
+
+  template <ColorOrder O>
+  void clear(OrderedLED<O>* leds, uint16_t len)
+  {
+    if (leds == nullptr) return;
+    memset((uint8_t*)leds, 0, len * sizeof(OrderedLED<O>));
+  }
+
+  template <ColorOrder O>
+  void fill(OrderedLED<O>* leds, uint16_t len, const OrderedLED<O>& color)
+  {
+    fillBytes(leds, len, &color, sizeof(OrderedLED<O>));
+  }
+
+  template <ColorOrder O>
+  void fill(OrderedLED<O>* leds, uint16_t len, uint32_t color)
+  {
+    fill(leds, len, OrderedLED<O>{color});
+  }
+
+  template <ColorOrder O>
+  void fill(OrderedLED<O>* leds, uint16_t len, uint8_t r, uint8_t g, uint8_t b)
+  {
+    fill(leds, len, OrderedLED<O>{r, g, b});
+  }
+
+  template <ColorOrder O>
+  void fillFromTo(OrderedLED<O>* leds, uint16_t len, const OrderedLED<O>& color, uint16_t from, uint16_t to)
+  {
+    if (leds == nullptr || from > to || to >= len) return;
+    fillBytes(leds + from, to - from + 1, &color, sizeof(OrderedLED<O>));
+  }
+
+  template <ColorOrder O>
+  void fillFromTo(OrderedLED<O>* leds, uint16_t len, uint32_t color, uint16_t from, uint16_t to)
+  {
+    fillFromTo(leds, len, OrderedLED<O>{color}, from, to);
+  }
+
+  template <ColorOrder O>
+  void fillFromTo(OrderedLED<O>* leds, uint16_t len, uint8_t r, uint8_t g, uint8_t b, uint16_t from, uint16_t to)
+  {
+    fillFromTo(leds, len, OrderedLED<O>{r, g, b}, from, to);
+  }
+
+  template <ColorOrder O>
+  void show(OrderedLED<O>* leds, uint16_t len, uint8_t pin, uint8_t bright = 255)
+  {
+    _extern_timer_show_bytes((const uint8_t*)leds, len * sizeof(OrderedLED<O>), pin, bright, pinTimer(pin));
+  }
+
+  class Strip;
   class StripGroup;
 
+  /**
+   * Optional output stage of the Strip. Brightness, gamma and white balance are fused in one
+   * lookup table per channel (768 bytes), rebuilt only when one of them changes. show() maps
+   * the LED buffer through it into the stage buffer and sends that buffer unscaled.
+   */
+  class OutputStage
+  {
+  public:
+    OutputStage();
+    OutputStage(LED* buffer, uint16_t len);
+    void changeBufferConfig(LED* buffer, uint16_t len);
+    void setGamma(bool enable);
+    bool getGamma() const;
+    void setWhiteBalance(uint8_t r, uint8_t g, uint8_t b);
+    void setWhiteBalance(uint32_t color);
+    Color getWhiteBalance() const;
+    uint16_t size() const;
+    const LED* render(const LED* leds, uint16_t len, uint8_t bright);
+#if WS2812B_DITHER
+    void setDitherBuffer(uint8_t* errors, uint16_t len);
+    bool isDithering() const;
+#endif
+
+  private:
+    void rebuild(uint8_t bright);
+#if WS2812B_DITHER
+    void renderDithered(const LED* leds, uint16_t len, uint8_t bright);
+#endif
+    LED* buffer;
+    uint16_t len;
+    bool gamma;
+    bool stale;
+    uint8_t lut_bright;
+    LED balance;
+    uint8_t lut[3][256]; // g, r, b - wire order of LED
+#if WS2812B_DITHER
+    uint8_t* dither; // 3 fractional error bytes per LED
+    uint16_t dither_len;
+#endif
+  };
+
+  void _extern_parallel_show(Strip* const* strips, uint8_t n, uint8_t bright, uint8_t* buffer, uint16_t size);
+
   class Strip
   {
   public:
@@ -80,6 +438,11 @@ namespace WS2812B
     Strip(LED* leds, uint16_t len, uint8_t pin, bool reverse = false);
     bool begin();
     void changeLEDsConfig(LED* leds, uint16_t len);
+    void changeLEDsConfig(LED* front, LED* back, uint16_t len);
+    bool isDoubleBuffered() const;
+    void setCopyForward(bool enable);
+    bool isCopyForward() const;
+    const LED* getFrontBuffer() const;
     void clear();
     void fill(uint32_t color);
     void fillFromTo(uint32_t color, uint16_t from, uint16_t to);
@@ -87,6 +450,14 @@ namespace WS2812B
     void fillFromTo(uint8_t r, uint8_t g, uint8_t b, uint16_t from, uint16_t to);
     void fill(const Color& color);
     void fillFromTo(const Color& color, uint16_t from, uint16_t to);
+    void fillFromPalette(const Palette16& palette, uint8_t start_index, uint8_t step, uint8_t bright = 255u, bool blend = true);
+    void fillFromPalette_P(const uint32_t* palette, uint8_t start_index, uint8_t step, uint8_t bright = 255u, bool blend = true);
+    void composite(const Layer* layers, uint8_t count);
+    // spans in logical LED order, clipped to the strip; return the number of LEDs copied
+    uint16_t writePixels(uint16_t offset, const LED* src, uint16_t n);
+    // 3 bytes per LED in the given order, 4 for GRBW / RGBW (W is added to r, g and b)
+    uint16_t writePixelsRGB(uint16_t offset, const uint8_t* src, uint16_t n, ColorOrder order = RGB);
+    uint16_t readPixels(uint16_t offset, LED* dst, uint16_t n) const;
     uint8_t getBrightness() const;
     uint8_t getPin() const;
     Color getPixelColor(uint16_t n) const;
@@ -99,20 +470,61 @@ namespace WS2812B
     void setPixelColor(uint16_t n, Color color);
     void setReverse(bool);
     void show();
+    void waitShowDone();
+    bool canShow() const;
+    void setChangeTracking(bool enable);
+    bool isChangeTracking() const;
+    bool isDirty() const;
+    void markDirty();
+    uint32_t framesSent() const;
+    uint32_t framesSkipped() const;
+    void resetFrameCounters();
+    void setOutputStage(OutputStage* stage);
+    OutputStage* getOutputStage() const;
+    // budget in mA at 5 V, 0 disables the limiter; show() sends the largest brightness <= bright that fits
+    void setPowerBudget(uint16_t milliamps, uint8_t ma_per_channel = 20u, uint8_t ma_idle_per_led = 1u);
+    uint16_t getPowerBudget() const;
+    uint32_t getEstimatedCurrent() const; // mA of the last frame, after limiting
+    uint8_t getAppliedBrightness() const;
     LED& operator[](uint16_t led);
 
   private:
+    uint32_t channelSum();
+    uint8_t limitPower(uint8_t b);
+    bool needsShow(uint8_t b) const;
+    void transmit(uint8_t b);
+    void markSent(uint8_t b);
     bool is_begin;
-    LED* leds;
+    LED* leds; // drawing buffer (back buffer when double buffered)
+    LED* front; // buffer handed to the transmitter, nullptr when single buffered
+    bool copy_forward;
     uint16_t count;
     uint8_t pin;
     bool reverse;
     uint32_t timer;
+    bool tracking;
+    bool dirty;
+    bool pending;
+    uint8_t sent_bright;
+    uint32_t frames_sent;
+    uint32_t frames_skipped;
+    OutputStage* stage;
+    uint16_t power_budget;
+    uint8_t ma_channel;
+    uint8_t ma_idle;
+    bool sum_valid;
+    uint32_t channel_sum; // sum of all channel bytes of leds
+    uint32_t estimated_ma;
+    uint8_t applied_bright;
 
   public:
     uint8_t bright;
 
     friend StripGroup;
+    friend class HDRBuffer;
+    friend class Rect;
+    friend class Effect;
+    friend void _extern_parallel_show(Strip* const* strips, uint8_t n, uint8_t bright, uint8_t* buffer, uint16_t size);
   };
 
   class StripGroup
@@ -120,8 +532,10 @@ namespace WS2812B
   public:
     StripGroup();
     StripGroup(Strip* strips, uint16_t len);
+    StripGroup(Strip* strips, uint16_t len, uint32_t* offsets);
     bool begin();
     void changeStripsConfig(Strip* strips, uint16_t len);
+    void changeStripsConfig(Strip* strips, uint16_t len, uint32_t* offsets);
     void clear();
     void fill(uint32_t color);
     void fillFromTo(uint32_t color, uint32_t from, uint32_t to);
@@ -129,6 +543,8 @@ namespace WS2812B
     void fillFromTo(uint8_t r, uint8_t g, uint8_t b, uint32_t from, uint32_t to);
     void fill(const Color& led_color);
     void fillFromTo(const Color& led_color, uint32_t from, uint32_t to);
+    void fillFromPalette(const Palette16& palette, uint8_t start_index, uint8_t step, uint8_t bright = 255u, bool blend = true);
+    void fillFromPalette_P(const uint32_t* palette, uint8_t start_index, uint8_t step, uint8_t bright = 255u, bool blend = true);
     uint8_t getBrightness() const;
     uint32_t getPixelColor(uint32_t n) const;
     uint16_t getStripByLED(uint32_t led) const;
@@ -138,106 +554,415 @@ namespace WS2812B
     void setPixelColor(uint32_t n, uint32_t color);
     void setPixelColor(uint32_t n, uint8_t r, uint8_t g, uint8_t b);
     void setPixelColor(uint32_t n, Color color);
+    // span versions split at strip boundaries, see Strip::writePixels()
+    uint32_t writePixels(uint32_t offset, const LED* src, uint32_t n);
+    uint32_t writePixelsRGB(uint32_t offset, const uint8_t* src, uint32_t n, ColorOrder order = RGB);
+    uint32_t readPixels(uint32_t offset, LED* dst, uint32_t n) const;
     void setBrightness(uint8_t b);
     void show();
     void show(uint16_t strip);
     void show(bool* strip_update_list, bool reset_list = true);
+    void setChangeTracking(bool enable);
+    // shared by all strips, their own budgets are not used by the group
+    void setPowerBudget(uint16_t milliamps, uint8_t ma_per_channel = 20u, uint8_t ma_idle_per_led = 1u);
+    uint16_t getPowerBudget() const;
+    uint32_t getEstimatedCurrent() const; // mA of the last frame, after limiting
+    uint8_t getAppliedBrightness() const;
+    // staging buffer of the parallel output, WS2812B_PARALLEL_BUFFER(leds of the longest strip) bytes
+    void setParallelBuffer(uint8_t* buffer, uint16_t size);
     LED& operator[](uint32_t led);
     
   private:
+    friend class HDRBuffer;
+    friend class FrameScheduler;
     void calcLEDsCount();
+    uint8_t limitPower();
     bool isBegin() const;
     LED& getLedReference(uint32_t n) const;
+    uint16_t locate(uint32_t& n) const;
     Strip* strips;
     uint16_t strip_count;
     uint32_t led_count;
+    uint32_t* offsets; // strip_count + 1 entries, first LED of every strip
+    uint16_t power_budget;
+    uint8_t ma_channel;
+    uint8_t ma_idle;
+    uint32_t estimated_ma;
+    uint8_t applied_bright;
+    uint8_t* parallel_buffer;
+    uint16_t parallel_size;
   
   public:
     uint8_t bright;
   };
 
-  // struct Pos
-  // {
-  //   Pos();
-  //   Pos(int16_t x, int16_t y);
-  //   int16_t x;
-  //   int16_t y;
-  // };
-
-  // struct Size
-  // {
-  //   Size();
-  //   Size(uint16_t w, uint16_t h);
-  //   union
-  //   {
-  //     uint16_t w;
-  //     uint16_t width;
-  //   };
-  //   union
-  //   {
-  //     uint16_t h;
-  //     uint16_t height;
-  //   };
-  // };
-
-  // class Rect
-  // {
-  // public:
-  //   enum connection_t : uint8_t
-  //   {
-  //     LINEAR,
-  //     CROSS
-  //   };
-
-  //   enum orientation_t : uint8_t
-  //   {
-  //     REVERSE,
-  //     NORMAL
-  //   };
-
-  //   Rect();
-  //   Rect(LED* led_matrix, uint16_t width, uint16_t height, uint8_t pin, connection_t connection_type = LINEAR);
-
-  //   uint8_t bright;
-  //   bool begin();
-  //   void changeLEDsConfig(LED* led_matrix, uint16_t width, uint16_t height);
-  //   void setConnectionType(Rect::connection_t);
-  //   void setXOrientation(Rect::orientation_t);
-  //   void setYOrientation(Rect::orientation_t);
-  //   Rect::connection_t getConnectionType() const;
-  //   Rect::orientation_t getXOrientation() const;
-  //   Rect::orientation_t getYOrientation() const;
-  //   uint16_t getWidth() const;
-  //   uint16_t getHeight() const;
-  //   uint16_t numLeds() const;
-  //   void drawRectangle(Pos pos, Size size, uint32_t color, bool fill = false);
-  //   void drawRectangle(Pos pos, uint16_t width, uint16_t height, uint32_t color, bool fill = false);
-  //   void drawRectangle(int16_t x, int16_t y, Size size, uint32_t color, bool fill = false);
-  //   void drawRectangle(int16_t x, int16_t y, uint16_t width, uint16_t height, uint32_t color, bool fill = false);
-  //   void drawLine(Pos begin, Pos end, uint32_t color);
-  //   void drawLine(int16_t x_begin, int16_t y_begin, Pos end, uint32_t color);
-  //   void drawLine(Pos begin, int16_t x_end, int16_t y_end, uint32_t color);
-  //   void drawLine(int16_t x_begin, int16_t y_begin, int16_t x_end, int16_t y_end, uint32_t color);
-  //   void drawCircle(Pos center, uint16_t r, uint32_t color, bool fill = false);
-  //   void drawCircle(int16_t x_center, int16_t y_center, uint16_t r, uint32_t color, bool fill = false);
-  //   void fill(uint32_t color);
-  //   void fill(uint8_t r, uint8_t g, uint8_t b);
-  //   void fill(const Color& color);
-  //   void clear();
-  //   LED& operator[](Pos pos);
-  //   LED& operator[](uint16_t);
-  //   void show();
-
-  // private:
-  //   void calcLedCount();
-  //   bool is_begin;
-  //   uint8_t pin;
-  //   orientation_t x_ori;
-  //   orientation_t y_ori;
-  //   Size dim;
-  //   LED* led_matrix;
-  //   uint16_t led_count;
-  //   connection_t con;
-  // };
+  template <uint16_t N>
+  class BufferedStrip : public Strip
+  {
+  public:
+    BufferedStrip(uint8_t pin, bool reverse = false) : Strip(nullptr, N, pin, reverse) 
+    {
+      changeLEDsConfig(buffers[0], buffers[1], N);
+    }
+    // the strip points into its own buffers, a copy would draw into and show the source's
+    BufferedStrip(const BufferedStrip&) = delete;
+    BufferedStrip& operator=(const BufferedStrip&) = delete;
+
+  private:
+    LED buffers[2][N];
+  };
+
+  // port register and bit mask of a pin known at compile time, fixed = false sends through the runtime pin lookup
+  template <uint8_t PIN>
+  struct PinTraits
+  {
+    static constexpr bool fixed = false;
+    static constexpr uint8_t io = 0;
+    static constexpr uint8_t mask = 0;
+  };
+
+  // transmit routine selected for a pin, the platform header specializes it for fixed pins
+  template <uint8_t PIN, bool FIXED = PinTraits<PIN>::fixed>
+  struct StaticShow
+  {
+    static void send(const uint8_t* bytes, uint16_t num_bytes, uint8_t bright, uint32_t& timer)
+    {
+      _extern_timer_show_bytes(bytes, num_bytes, PIN, bright, timer);
+    }
+  };
+
+  /**
+   * Strip with its length and pin fixed at compile time and its own buffer.
+   * Without reverse, runtime pin, change tracking and output stage it is just the buffer,
+   * brightness and latch timer; on AVR the frame is sent by a routine built for the pin.
+   */
+  template <uint16_t N, uint8_t PIN, ColorOrder O = GRB>
+  class StaticStrip
+  {
+  public:
+    using PixelType = OrderedLED<O>;
+
+    StaticStrip() : bright{255}, timer{0u}, leds{} {}
+
+    bool begin() { return WS2812B::begin(PIN); }
+    void clear() { WS2812B::clear(leds, N); }
+    void fill(uint32_t color) { WS2812B::fill(leds, N, color); }
+    void fill(uint8_t r, uint8_t g, uint8_t b) { WS2812B::fill(leds, N, r, g, b); }
+    void fill(const Color& color) { WS2812B::fill(leds, N, PixelType{color}); }
+    void fillFromTo(uint32_t color, uint16_t from, uint16_t to) { WS2812B::fillFromTo(leds, N, color, from, to); }
+    void fillFromTo(uint8_t r, uint8_t g, uint8_t b, uint16_t from, uint16_t to) { WS2812B::fillFromTo(leds, N, r, g, b, from, to); }
+    void fillFromTo(const Color& color, uint16_t from, uint16_t to) { WS2812B::fillFromTo(leds, N, PixelType{color}, from, to); }
+    uint8_t getBrightness() const { return bright; }
+    void setBrightness(uint8_t b) { bright = b; }
+    static constexpr uint8_t getPin() { return PIN; }
+    static constexpr uint16_t numPixels() { return N; }
+    static constexpr ColorOrder getColorOrder() { return O; }
+    Color getPixelColor(uint16_t n) const { return n < N ? (Color)leds[n] : Color{0u}; }
+    void setPixelColor(uint16_t n, uint32_t color) { if (n < N) leds[n] = PixelType{color}; }
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) { if (n < N) leds[n].set(r, g, b); }
+    void setPixelColor(uint16_t n, Color color) { if (n < N) leds[n] = PixelType{color}; }
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w) { if (n < N) leds[n].setRGBW(r, g, b, w); }
+    PixelType* data() { return leds; }
+    void show() { StaticShow<PIN>::send((const uint8_t*)leds, N * sizeof(PixelType), bright, timer); }
+    PixelType& operator[](uint16_t n) { return leds[n]; }
+
+    uint8_t bright;
+
+  private:
+    uint32_t timer;
+    PixelType leds[N];
+  };
+
+  /**
+   * 16-bit per channel render target for a Strip or a StripGroup. Drawing, mixing and
+   * accumulating happen at full precision, show() converts to the LED buffers in one batch.
+   */
+  class HDRBuffer
+  {
+  public:
+    HDRBuffer();
+    HDRBuffer(LED16* pixels, Strip* strip);
+    HDRBuffer(LED16* pixels, StripGroup* group);
+    void changeConfig(LED16* pixels, Strip* strip);
+    void changeConfig(LED16* pixels, StripGroup* group);
+    void clear();
+    void fill(const LED16& color);
+    void fillFromTo(const LED16& color, uint32_t from, uint32_t to);
+    void setPixelColor(uint32_t n, const LED16& color);
+    void setPixelColor(uint32_t n, uint16_t r, uint16_t g, uint16_t b);
+    void addPixelColor(uint32_t n, const LED16& color);
+    LED16 getPixelColor(uint32_t n) const;
+    uint32_t numPixels() const;
+    void setGamma(bool enable);
+    bool getGamma() const;
+    void render();
+    void show();
+    LED16& operator[](uint32_t n);
+
+  private:
+    void renderStrip(Strip& strip, const LED16* src);
+    LED16* pixels;
+    Strip* strip;
+    StripGroup* group;
+    uint32_t count;
+    bool gamma;
+  };
+
+  template <uint16_t N>
+  class IndexedStripGroup : public StripGroup
+  {
+  public:
+    IndexedStripGroup() : StripGroup() {}
+    IndexedStripGroup(Strip* strips) : StripGroup() 
+    {
+      StripGroup::changeStripsConfig(strips, N, offset_table);
+    }
+    void changeStripsConfig(Strip* strips)
+    {
+      StripGroup::changeStripsConfig(strips, N, offset_table);
+    }
+    // the group points into its own offset_table, a copy would share it
+    IndexedStripGroup(const IndexedStripGroup&) = delete;
+    IndexedStripGroup& operator=(const IndexedStripGroup&) = delete;
+
+  private:
+    uint32_t offset_table[N + 1];
+  };
+
+  /**
+   * Paces rendering and output to a fixed frame rate from loop() without blocking.
+   * tick() calls the render callback when a frame is due and sends every strip whose latch
+   * has expired; a strip still latching is sent on a later tick instead of being waited for.
+   * The callback returns false when nothing changed, the frame is then not sent at all.
+   * Up to 32 strips, or one StripGroup which keeps its parallel output.
+   */
+  class FrameScheduler
+  {
+  public:
+    FrameScheduler();
+    FrameScheduler(Strip* strips, uint16_t len, uint16_t fps, bool (*render)(uint32_t frame) = nullptr);
+    FrameScheduler(StripGroup* group, uint16_t fps, bool (*render)(uint32_t frame) = nullptr);
+    void setFrameRate(uint16_t fps);
+    uint16_t getFrameRate() const;
+    void onRender(bool (*render)(uint32_t frame));
+    bool tick();
+    bool isSending() const;
+    uint32_t framesRendered() const;
+    uint32_t framesDropped() const;
+    uint32_t framesIdle() const;
+    uint32_t renderTime() const;
+    uint32_t transmitTime() const;
+    void resetStats();
+
+  private:
+    void send();
+    Strip* strips;
+    uint16_t strip_count;
+    StripGroup* group;
+    bool (*render)(uint32_t frame);
+    uint16_t fps;
+    uint32_t period; // us
+    uint32_t next_due;
+    bool started;
+    uint32_t pending; // bit per strip of the current frame not sent yet
+    uint32_t frame;
+    uint32_t frames_rendered;
+    uint32_t frames_dropped;
+    uint32_t frames_idle;
+    uint32_t render_us; // last frame
+    uint32_t transmit_us; // last frame, sum of all its show() calls
+  };
+
+  enum Easing : uint8_t
+  {
+    EASE_LINEAR,
+    EASE_IN_QUAD,
+    EASE_OUT_QUAD,
+    EASE_IN_OUT_QUAD,
+    EASE_IN_OUT_CUBIC
+  };
+
+  // t and the result are 0.16 fixed point (0 - 65535), no floats
+  uint16_t ease(Easing easing, uint16_t t);
+
+  enum TweenFlags : uint8_t
+  {
+    TWEEN_ONCE = 0,
+    TWEEN_LOOP = 1, // restarts from the beginning
+    TWEEN_YOYO = 2 // runs back and forth, implies loop
+  };
+
+  /**
+   * One animation slot of an Animator (21 bytes on AVR). Slots are allocated by the caller,
+   * their fields are managed by the Animator.
+   */
+  struct Tween
+  {
+    Tween() : start{0u}, duration{0u}, from{0u}, to{0u}, kind{0}, easing{EASE_LINEAR}, flags{0}, last{0u} {}
+    uint32_t start; // ms
+    uint16_t duration; // ms
+    uint16_t from;
+    uint16_t to;
+    uint8_t kind;
+    Easing easing;
+    uint8_t flags;
+    uint16_t last; // eased progress written last time
+    union
+    {
+      struct { LED a, b; } color;
+      struct { uint16_t start, span; uint8_t sat, val; } hue;
+      struct { LED color; uint8_t from, to; } fade;
+    };
+  };
+
+  /**
+   * Runs tweens over segments (from - to, inclusive) of a Strip or a StripGroup.
+   * update() evaluates every running tween once and fills its segment only when the eased
+   * progress changed, so it returns whether anything was drawn and can be used directly as
+   * a FrameScheduler render callback result. Later slots draw over earlier ones.
+   */
+  class Animator
+  {
+  public:
+    Animator();
+    Animator(Tween* slots, uint8_t len, Strip* strip);
+    Animator(Tween* slots, uint8_t len, StripGroup* group);
+    int8_t color(uint16_t from, uint16_t to, const Color& a, const Color& b, uint16_t duration, Easing easing = EASE_LINEAR, uint8_t flags = TWEEN_ONCE);
+    int8_t hue(uint16_t from, uint16_t to, uint16_t hue_start, uint16_t hue_span, uint16_t duration, Easing easing = EASE_LINEAR, uint8_t flags = TWEEN_ONCE, uint8_t sat = 255u, uint8_t val = 255u);
+    int8_t fade(uint16_t from, uint16_t to, const Color& color, uint8_t level_from, uint8_t level_to, uint16_t duration, Easing easing = EASE_LINEAR, uint8_t flags = TWEEN_ONCE);
+    void stop(int8_t id);
+    void stopAll();
+    bool isActive(int8_t id) const;
+    bool isAnimating() const;
+    bool update();
+    bool update(uint32_t now);
+
+  private:
+    int8_t add(uint8_t kind, uint16_t from, uint16_t to, uint16_t duration, Easing easing, uint8_t flags);
+    Color evaluate(const Tween& tween, uint16_t progress) const;
+    void draw(const Color& color, uint16_t from, uint16_t to);
+    Tween* slots;
+    uint8_t slot_count;
+    Strip* strip;
+    StripGroup* group;
+  };
+
+  struct Pos
+  {
+    Pos();
+    Pos(int16_t x, int16_t y);
+    int16_t x;
+    int16_t y;
+  };
+
+  struct Size
+  {
+    Size();
+    Size(uint16_t w, uint16_t h);
+    union
+    {
+      uint16_t w;
+      uint16_t width;
+    };
+    union
+    {
+      uint16_t h;
+      uint16_t height;
+    };
+  };
+
+  /**
+   * LED matrix made of one or more tiles. Every tile is a Strip wired column by column,
+   * tiles are ordered row by row. Pixels are resolved through an optional XY table
+   * (RAM, built in begin(), or PROGMEM), filled shapes are drawn as contiguous column spans.
+   */
+  class Rect
+  {
+  public:
+    enum connection_t : uint8_t
+    {
+      LINEAR,
+      CROSS
+    };
+
+    enum orientation_t : uint8_t
+    {
+      REVERSE,
+      NORMAL
+    };
+
+    Rect();
+    Rect(LED* led_matrix, uint16_t width, uint16_t height, uint8_t pin, connection_t connection_type = LINEAR);
+    Rect(Strip* tiles, uint8_t tiles_x, uint8_t tiles_y, uint16_t tile_width, uint16_t tile_height, connection_t connection_type = LINEAR);
+
+    // LED index of (x, y) inside one tile of the given height (tiles are wired column by column),
+    // usable to generate PROGMEM tables at compile time
+    static constexpr uint16_t index(uint16_t x, uint16_t y, uint16_t height, connection_t connection)
+    {
+      return connection == CROSS ? x * height + y : x * height + ((x & 1) ? height - 1 - y : y);
+    }
+
+    uint8_t bright;
+    bool begin();
+    void changeLEDsConfig(LED* led_matrix, uint16_t width, uint16_t height);
+    void setXYTable(LED** table);
+    void setXYTable_P(const uint16_t* table);
+    void setConnectionType(Rect::connection_t);
+    void setXOrientation(Rect::orientation_t);
+    void setYOrientation(Rect::orientation_t);
+    Rect::connection_t getConnectionType() const;
+    Rect::orientation_t getXOrientation() const;
+    Rect::orientation_t getYOrientation() const;
+    uint16_t getWidth() const;
+    uint16_t getHeight() const;
+    uint16_t numLeds() const;
+    void drawPixel(int16_t x, int16_t y, uint32_t color);
+    void drawRectangle(Pos pos, Size size, uint32_t color, bool fill = false);
+    void drawRectangle(Pos pos, uint16_t width, uint16_t height, uint32_t color, bool fill = false);
+    void drawRectangle(int16_t x, int16_t y, Size size, uint32_t color, bool fill = false);
+    void drawRectangle(int16_t x, int16_t y, uint16_t width, uint16_t height, uint32_t color, bool fill = false);
+    void drawLine(Pos begin, Pos end, uint32_t color);
+    void drawLine(int16_t x_begin, int16_t y_begin, Pos end, uint32_t color);
+    void drawLine(Pos begin, int16_t x_end, int16_t y_end, uint32_t color);
+    void drawLine(int16_t x_begin, int16_t y_begin, int16_t x_end, int16_t y_end, uint32_t color);
+    void drawCircle(Pos center, uint16_t r, uint32_t color, bool fill = false);
+    void drawCircle(int16_t x_center, int16_t y_center, uint16_t r, uint32_t color, bool fill = false);
+    void fill(uint32_t color);
+    void fill(uint8_t r, uint8_t g, uint8_t b);
+    void fill(const Color& color);
+    void clear();
+    LED& operator[](Pos pos);
+    LED& operator[](uint16_t);
+    void show();
+
+  private:
+    void calcLedCount();
+    uint16_t tileCount() const;
+    Strip& tileAt(uint16_t i);
+    void touch();
+    void buildTable();
+    LED* ledAt(int16_t x, int16_t y);
+    LED* ledAtIndex(uint16_t i);
+    LED* mapLed(int16_t x, int16_t y);
+    void fillColumn(int16_t x, int16_t y0, int16_t y1, const Color& color);
+    void fillRow(int16_t y, int16_t x0, int16_t x1, const Color& color);
+    bool is_begin;
+    Strip own;
+    Strip* tiles;
+    uint8_t tiles_x;
+    uint8_t tiles_y;
+    Size tile;
+    orientation_t x_ori;
+    orientation_t y_ori;
+    Size dim;
+    uint16_t led_count;
+    connection_t con;
+    LED** xy_table; // width * height entries, row by row
+    const uint16_t* xy_table_P; // PROGMEM, width * height LED indices, row by row
+  };
 
 }
+
+#ifdef AVR
+#include "atmega.hpp"
+#endif
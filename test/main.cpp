@@ -0,0 +1,43 @@
+#include "test.hpp"
+
+namespace test
+{
+  static Case* first = nullptr;
+  static Case* last = nullptr;
+  static int failed_checks = 0;
+
+  void add(Case* c)
+  {
+    if (last) last->next = c;
+    else first = c;
+    last = c;
+  }
+
+  void fail(const char* file, int line, const char* what)
+  {
+    printf("  %s:%d: CHECK(%s) failed\n", file, line, what);
+    ++failed_checks;
+  }
+
+  void failEq(const char* file, int line, const char* a, const char* b, long long va, long long vb)
+  {
+    printf("  %s:%d: %s == %s failed (%lld != %lld)\n", file, line, a, b, va, vb);
+    ++failed_checks;
+  }
+}
+
+int main()
+{
+  int cases = 0, failed = 0;
+  for (test::Case* c = test::first; c; c = c->next)
+  {
+    int before = test::failed_checks;
+    c->run();
+    ++cases;
+    bool ok = test::failed_checks == before;
+    if (!ok) ++failed;
+    printf("%s %s\n", ok ? "ok  " : "FAIL", c->name);
+  }
+  printf("%d/%d passed\n", cases - failed, cases);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Subset of the ESP-IDF legacy RMT driver used by src/esp32.cpp, implemented in rmt_stub.cpp.
+
+#define IRAM_ATTR
+#define ESP_OK 0
+#define ESP_ERR_TIMEOUT 0x107
+#define portMAX_DELAY 0xFFFFFFFFu
+
+typedef int esp_err_t;
+typedef uint32_t TickType_t;
+typedef int gpio_num_t;
+
+typedef enum
+{
+  RMT_CHANNEL_0,
+  RMT_CHANNEL_1,
+  RMT_CHANNEL_2,
+  RMT_CHANNEL_3,
+  RMT_CHANNEL_4,
+  RMT_CHANNEL_5,
+  RMT_CHANNEL_6,
+  RMT_CHANNEL_7,
+  RMT_CHANNEL_MAX
+} rmt_channel_t;
+
+typedef struct
+{
+  union
+  {
+    struct
+    {
+      uint32_t duration0 : 15;
+      uint32_t level0 : 1;
+      uint32_t duration1 : 15;
+      uint32_t level1 : 1;
+    };
+    uint32_t val;
+  };
+} rmt_item32_t;
+
+typedef struct
+{
+  rmt_channel_t channel;
+  gpio_num_t gpio_num;
+  uint8_t clk_div;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) {channel_id, gpio, 80}
+
+typedef void (*sample_to_rmt_t)(const void* src, rmt_item32_t* dest, size_t src_size, size_t wanted_num, size_t* translated_size, size_t* item_num);
+typedef void (*rmt_tx_end_fn_t)(rmt_channel_t channel, void* arg);
+
+esp_err_t rmt_config(const rmt_config_t* config);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags);
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn);
+esp_err_t rmt_translator_set_context(rmt_channel_t channel, void* context);
+esp_err_t rmt_translator_get_context(const size_t* item_num, void** context);
+rmt_tx_end_fn_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void* arg);
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t* src, size_t src_size, bool wait_tx_done);
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time);
+
+// test access
+namespace rmt_stub
+{
+  struct Channel
+  {
+    bool installed;
+    int gpio;
+    uint8_t clk_div;
+    bool busy;
+    uint32_t writes;
+    rmt_item32_t items[4096]; // items of the last write
+    size_t item_count;
+  };
+
+  const Channel& channel(rmt_channel_t channel);
+  // RMT memory block per translator call, the driver refills it in chunks
+  constexpr size_t BLOCK_ITEMS = 64;
+  // transmit end interrupt of a busy channel, the wire time passes on the host clock
+  void finish(rmt_channel_t channel);
+}
@@ -0,0 +1,97 @@
+#include <driver/rmt.h>
+#include "ws2812b.hpp"
+
+static rmt_stub::Channel channels[RMT_CHANNEL_MAX];
+static sample_to_rmt_t translators[RMT_CHANNEL_MAX];
+static void* contexts[RMT_CHANNEL_MAX];
+static rmt_tx_end_fn_t tx_end = nullptr;
+static void* tx_end_arg = nullptr;
+static rmt_channel_t translating = RMT_CHANNEL_0;
+
+esp_err_t rmt_config(const rmt_config_t* config)
+{
+  channels[config->channel].gpio = config->gpio_num;
+  channels[config->channel].clk_div = config->clk_div;
+  return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t, int)
+{
+  channels[channel].installed = true;
+  return ESP_OK;
+}
+
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn)
+{
+  translators[channel] = fn;
+  return ESP_OK;
+}
+
+esp_err_t rmt_translator_set_context(rmt_channel_t channel, void* context)
+{
+  contexts[channel] = context;
+  return ESP_OK;
+}
+
+// the driver finds the channel from the item_num pointer, the stub knows which one is translating
+esp_err_t rmt_translator_get_context(const size_t*, void** context)
+{
+  *context = contexts[translating];
+  return ESP_OK;
+}
+
+rmt_tx_end_fn_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void* arg)
+{
+  rmt_tx_end_fn_t previous = tx_end;
+  tx_end = function;
+  tx_end_arg = arg;
+  return previous;
+}
+
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t* src, size_t src_size, bool)
+{
+  rmt_stub::Channel& ch = channels[channel];
+  ch.item_count = 0;
+  ++ch.writes;
+  translating = channel;
+  size_t done = 0;
+  while (done < src_size)
+  {
+    size_t room = sizeof(ch.items) / sizeof(ch.items[0]) - ch.item_count;
+    size_t wanted = room < rmt_stub::BLOCK_ITEMS ? room : rmt_stub::BLOCK_ITEMS;
+    size_t translated = 0, items = 0;
+    translators[channel](src + done, ch.items + ch.item_count, src_size - done, wanted, &translated, &items);
+    if (translated == 0) break;
+    done += translated;
+    ch.item_count += items;
+  }
+  ch.busy = true;
+  return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time)
+{
+  if (!channels[channel].busy) return ESP_OK;
+  if (wait_time == 0) return ESP_ERR_TIMEOUT;
+  rmt_stub::finish(channel);
+  return ESP_OK;
+}
+
+namespace rmt_stub
+{
+  const Channel& channel(rmt_channel_t channel)
+  {
+    return channels[channel];
+  }
+
+  void finish(rmt_channel_t channel)
+  {
+    Channel& ch = channels[channel];
+    if (!ch.busy) return;
+    uint64_t ticks = 0;
+    for (size_t i = 0; i < ch.item_count; ++i) ticks += ch.items[i].duration0 + ch.items[i].duration1;
+    WS2812B::host::advanceNs((uint32_t)(ticks * ch.clk_div * 1000u / 80u)); // 80 MHz APB clock
+    ch.busy = false;
+    if (tx_end) tx_end(channel, tx_end_arg);
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdio.h>
+#include "ws2812b.hpp"
+
+/**
+ * Minimal test runner for the host build. TEST(name) registers a case, CHECK* report the
+ * failing expression and the case goes on; the executable returns non zero when any failed.
+ */
+
+namespace test
+{
+  struct Case
+  {
+    const char* name;
+    void (*run)();
+    Case* next;
+  };
+
+  void add(Case* c);
+  void fail(const char* file, int line, const char* what);
+  void failEq(const char* file, int line, const char* a, const char* b, long long va, long long vb);
+
+  // pseudo random colors, the same for the same seed
+  inline void fillPattern(WS2812B::LED* leds, uint16_t len, uint32_t seed)
+  {
+    for (uint16_t i = 0; i < len; ++i)
+    {
+      seed = seed * 1103515245u + 12345u;
+      leds[i] = WS2812B::LED(seed >> 24, seed >> 16, seed >> 8);
+    }
+  }
+}
+
+#define TEST(NAME) \
+  static void NAME(); \
+  static test::Case NAME##_case{#NAME, NAME, nullptr}; \
+  static const bool NAME##_added = (test::add(&NAME##_case), true); \
+  static void NAME()
+
+#define CHECK(COND) \
+  do { if (!(COND)) test::fail(__FILE__, __LINE__, #COND); } while (0)
+
+#define CHECK_EQ(A, B) \
+  do \
+  { \
+    long long a_ = (long long)(A), b_ = (long long)(B); \
+    if (a_ != b_) test::failEq(__FILE__, __LINE__, #A, #B, a_, b_); \
+  } while (0)
+
+// |A - B| <= TOL
+#define CHECK_NEAR(A, B, TOL) \
+  do \
+  { \
+    double a_ = (A), b_ = (B); \
+    if (a_ - b_ > (TOL) || b_ - a_ > (TOL)) test::fail(__FILE__, __LINE__, #A " ~ " #B); \
+  } while (0)
@@ -0,0 +1,154 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+#include <type_traits>
+
+using namespace WS2812B;
+
+#define PIN 8
+#define LEDS 6
+
+static bool wireIs(uint8_t pin, uint32_t color)
+{
+  uint8_t wire[LEDS * 3];
+  if (host::decode(pin, wire, sizeof(wire)) != LEDS * 3) return false;
+  LED c(color);
+  const uint8_t* bytes = (const uint8_t*)&c;
+  for (uint8_t i = 0; i < LEDS * 3; ++i)
+  {
+    if (wire[i] != (uint8_t)((bytes[i % 3] * 255) >> 8)) return false; // default brightness 255
+  }
+  return true;
+}
+
+TEST(show_swaps_front_and_back)
+{
+  host::reset();
+  LED a[LEDS], b[LEDS];
+  Strip strip;
+  strip.changeLEDsConfig(a, b, LEDS);
+  strip.setPin(PIN);
+  strip.begin();
+  CHECK(strip.isDoubleBuffered());
+  CHECK(strip.getFrontBuffer() == a);
+
+  strip.fill(0x0000FFul); // draws into b
+  CHECK(b[0] == LED(0x0000FFul));
+  CHECK(a[0] == 0u);
+  strip.show();
+  CHECK(strip.getFrontBuffer() == b); // sent buffer belongs to the transmitter now
+  CHECK(wireIs(PIN, 0x0000FFul));
+
+  strip.setPixelColor(0, 0xFF0000ul); // draws into a
+  CHECK(a[0] == LED(0xFF0000ul));
+  CHECK(b[0] == LED(0x0000FFul));
+  strip.show();
+  CHECK(strip.getFrontBuffer() == a);
+}
+
+TEST(copy_forward_keeps_incremental_drawing)
+{
+  host::reset();
+  LED a[LEDS], b[LEDS];
+  Strip strip;
+  strip.changeLEDsConfig(a, b, LEDS);
+  strip.setPin(PIN);
+  strip.begin();
+  CHECK(strip.isCopyForward());
+
+  strip.fill(0x102030ul);
+  strip.show();
+  CHECK(a[LEDS - 1] == LED(0x102030ul)); // new back starts from the sent frame
+  strip.setPixelColor(0, 0xFFFFFFul);
+  strip.show();
+  uint8_t wire[LEDS * 3];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), LEDS * 3);
+  CHECK_EQ(wire[0], (0xFF * 255) >> 8);
+  CHECK_EQ(wire[3], (0x20 * 255) >> 8);
+}
+
+TEST(without_copy_forward_back_holds_older_frame)
+{
+  host::reset();
+  LED a[LEDS], b[LEDS];
+  Strip strip;
+  strip.changeLEDsConfig(a, b, LEDS);
+  strip.setPin(PIN);
+  strip.begin();
+  strip.setCopyForward(false);
+
+  strip.fill(0x000001ul);
+  strip.show(); // b sent, drawing in a
+  CHECK(strip.getPixelColor(0) == 0u);
+  strip.fill(0x000002ul);
+  strip.show(); // a sent, drawing in b
+  CHECK(strip.getPixelColor(0) == LED(0x000001ul));
+  CHECK(wireIs(PIN, 0x000002ul));
+}
+
+TEST(single_buffer_config_drops_front)
+{
+  LED a[LEDS], b[LEDS], c[LEDS];
+  Strip strip;
+  strip.changeLEDsConfig(a, b, LEDS);
+  strip.changeLEDsConfig(c, LEDS);
+  CHECK(!strip.isDoubleBuffered());
+  CHECK(strip.getFrontBuffer() == c);
+}
+
+TEST(buffered_strip_owns_both_buffers)
+{
+  host::reset();
+  BufferedStrip<LEDS> strip(PIN);
+  strip.begin();
+  CHECK(strip.isDoubleBuffered());
+  CHECK_EQ(strip.numPixels(), LEDS);
+  const LED* first = strip.getFrontBuffer();
+  strip.fill(0x00FF00ul);
+  strip.show();
+  CHECK(strip.getFrontBuffer() != first);
+  CHECK(wireIs(PIN, 0x00FF00ul));
+  strip.show();
+  CHECK(strip.getFrontBuffer() == first);
+}
+
+TEST(buffered_strip_stays_in_its_own_buffers)
+{
+  CHECK(!std::is_copy_constructible<BufferedStrip<LEDS>>::value);
+  CHECK(!std::is_copy_assignable<BufferedStrip<LEDS>>::value);
+
+  host::reset();
+  BufferedStrip<LEDS> strip(PIN);
+  strip.begin();
+  const uint8_t* begin = (const uint8_t*)&strip;
+  const uint8_t* end = (const uint8_t*)(&strip + 1);
+  for (uint8_t i = 0; i < 2; ++i, strip.show())
+  {
+    const uint8_t* front = (const uint8_t*)strip.getFrontBuffer();
+    const uint8_t* draw = (const uint8_t*)&strip[0];
+    CHECK(front >= begin && front + LEDS * 3 <= end);
+    CHECK(draw >= begin && draw + LEDS * 3 <= end);
+    CHECK(front != draw);
+  }
+}
+
+TEST(group_batches_swap_too)
+{
+  host::reset();
+  static LED a[2][LEDS], b[2][LEDS];
+  Strip strips[2];
+  for (uint8_t s = 0; s < 2; ++s)
+  {
+    strips[s].changeLEDsConfig(a[s], b[s], LEDS);
+    strips[s].setPin(PIN + s);
+  }
+  StripGroup group(strips, 2);
+  group.begin();
+  group.fill(0x808080ul);
+  group.show();
+  for (uint8_t s = 0; s < 2; ++s)
+  {
+    CHECK(strips[s].getFrontBuffer() == b[s]);
+    CHECK(a[s][0] == LED(0x808080ul));
+    CHECK(wireIs(PIN + s, 0x808080ul));
+  }
+}
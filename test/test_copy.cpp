@@ -0,0 +1,147 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+#define PIN 5
+#define LEDS 10
+
+static LED colorAt(uint16_t i)
+{
+  return LED(i * 29u + 1u, i * 53u + 2u, 255u - i * 17u);
+}
+
+static void fillColors(LED* leds, uint16_t len)
+{
+  for (uint16_t i = 0; i < len; ++i) leds[i] = colorAt(i);
+}
+
+TEST(write_clips_at_the_end)
+{
+  LED leds[LEDS];
+  LED src[LEDS];
+  fillColors(src, LEDS);
+  Strip strip(leds, LEDS, PIN);
+
+  CHECK_EQ(strip.writePixels(7, src, LEDS), 3);
+  for (uint8_t i = 0; i < 7; ++i) CHECK(leds[i] == LED(0u));
+  for (uint8_t i = 0; i < 3; ++i) CHECK(leds[7 + i] == src[i]);
+  CHECK_EQ(strip.writePixels(LEDS, src, 1), 0);
+  CHECK_EQ(strip.writePixels(0, nullptr, 1), 0);
+
+  LED dst[LEDS];
+  CHECK_EQ(strip.readPixels(8, dst, 5), 2);
+  CHECK(dst[0] == src[1]);
+  CHECK(dst[1] == src[2]);
+  CHECK_EQ(strip.readPixels(LEDS, dst, 1), 0);
+
+  uint8_t rgb[LEDS * 3];
+  CHECK_EQ(strip.writePixelsRGB(9, rgb, 4), 1);
+}
+
+TEST(reversed_strip_keeps_logical_order)
+{
+  LED leds[LEDS];
+  LED src[4];
+  fillColors(src, 4);
+  Strip strip(leds, LEDS, PIN, true);
+
+  CHECK_EQ(strip.writePixels(2, src, 4), 4);
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    CHECK(leds[LEDS - 1 - 2 - i] == src[i]);
+    CHECK_EQ(strip.getPixelColor(2 + i), (uint32_t)LED(src[i]));
+  }
+
+  LED dst[4];
+  CHECK_EQ(strip.readPixels(2, dst, 4), 4);
+  for (uint8_t i = 0; i < 4; ++i) CHECK(dst[i] == src[i]);
+
+  // clipped at the logical end, which is the start of the buffer
+  CHECK_EQ(strip.writePixels(8, src, 4), 2);
+  CHECK(leds[1] == src[0]);
+  CHECK(leds[0] == src[1]);
+}
+
+template <typename GROUP>
+static void checkGroupSpan(GROUP& group, Strip* strips, LED (*leds)[5])
+{
+  LED src[12];
+  fillColors(src, 12);
+  // strips of 4, 5 (reversed) and 3 LEDs, the span covers LEDs 2 - 9
+  CHECK_EQ(group.writePixels(2, src, 8), 8u);
+  CHECK(leds[0][2] == src[0]);
+  CHECK(leds[0][3] == src[1]);
+  for (uint8_t i = 0; i < 5; ++i) CHECK(leds[1][4 - i] == src[2 + i]);
+  CHECK(leds[2][0] == src[7]);
+  CHECK(leds[2][1] == LED(0u));
+
+  LED dst[12];
+  CHECK_EQ(group.readPixels(2, dst, 8), 8u);
+  for (uint8_t i = 0; i < 8; ++i) CHECK(dst[i] == src[i]);
+
+  // past the end of the last strip
+  CHECK_EQ(group.writePixels(10, src, 5), 2u);
+  CHECK(leds[2][1] == src[0]);
+  CHECK(leds[2][2] == src[1]);
+  CHECK_EQ(group.readPixels(11, dst, 5), 1u);
+  CHECK_EQ(group.writePixels(12, src, 1), 0u);
+
+  // 4 byte source pixels across the reversed strip
+  uint8_t rgbw[6 * 4];
+  for (uint8_t i = 0; i < 6; ++i)
+  {
+    OrderedLED<RGBW> p(src[i]);
+    for (uint8_t k = 0; k < 4; ++k) rgbw[i * 4 + k] = p.bytes[k];
+  }
+  CHECK_EQ(group.writePixelsRGB(3, rgbw, 6, RGBW), 6u);
+  CHECK(leds[0][3] == src[0]);
+  for (uint8_t i = 0; i < 5; ++i) CHECK(leds[1][4 - i] == src[1 + i]);
+  CHECK(strips[1].isReverse());
+}
+
+TEST(group_span_crosses_strips)
+{
+  static LED leds[3][5];
+  for (uint8_t s = 0; s < 3; ++s) clear(leds[s], 5);
+  Strip strips[3] = {Strip(leds[0], 4, PIN), Strip(leds[1], 5, PIN + 1, true), Strip(leds[2], 3, PIN + 2)};
+  StripGroup group(strips, 3);
+  checkGroupSpan(group, strips, leds);
+}
+
+TEST(indexed_group_span_crosses_strips)
+{
+  static LED leds[3][5];
+  for (uint8_t s = 0; s < 3; ++s) clear(leds[s], 5);
+  Strip strips[3] = {Strip(leds[0], 4, PIN), Strip(leds[1], 5, PIN + 1, true), Strip(leds[2], 3, PIN + 2)};
+  IndexedStripGroup<3> group(strips);
+  checkGroupSpan(group, strips, leds);
+}
+
+// the source in the wire order of O, read back as the same colors
+template <ColorOrder O>
+static void checkOrder()
+{
+  OrderedLED<O> src[LEDS];
+  for (uint8_t i = 0; i < LEDS; ++i) src[i] = OrderedLED<O>(colorAt(i));
+  LED leds[LEDS];
+  Strip strip(leds, LEDS, PIN);
+  CHECK_EQ(strip.writePixelsRGB(0, (const uint8_t*)src, LEDS, O), LEDS);
+  for (uint8_t i = 0; i < LEDS; ++i) CHECK(leds[i] == colorAt(i));
+
+  strip.setReverse(true);
+  CHECK_EQ(strip.writePixelsRGB(1, (const uint8_t*)src, LEDS, O), LEDS - 1);
+  for (uint8_t i = 0; i < LEDS - 1; ++i) CHECK(leds[LEDS - 2 - i] == colorAt(i));
+}
+
+TEST(write_rgb_every_color_order)
+{
+  checkOrder<GRB>();
+  checkOrder<RGB>();
+  checkOrder<BRG>();
+  checkOrder<RBG>();
+  checkOrder<GBR>();
+  checkOrder<BGR>();
+  checkOrder<GRBW>();
+  checkOrder<RGBW>();
+}
@@ -0,0 +1,107 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+#define PIN 5
+#define LEDS 8
+#define FRAMES 256
+
+// exact output of v at bright with white balance 255: v * (bright + 1) / 256
+static double exact(uint8_t v, uint8_t bright)
+{
+  return v * (bright + 1u) / 256.0;
+}
+
+TEST(dither_is_built)
+{
+  CHECK_EQ(WS2812B_DITHER, 1);
+}
+
+TEST(mean_over_frames_follows_unquantized_value)
+{
+  LED in[LEDS], out[LEDS];
+  uint8_t errors[LEDS * 3];
+  for (uint8_t i = 0; i < LEDS; ++i) in[i] = LED(100 + i, 37 * i, 255 - i);
+  OutputStage stage(out, LEDS);
+  stage.setDitherBuffer(errors, LEDS);
+  CHECK(stage.isDithering());
+
+  const uint8_t brights[3] = {10, 77, 200};
+  for (uint8_t b = 0; b < 3; ++b)
+  {
+    uint32_t sums[LEDS][3] = {};
+    for (uint16_t f = 0; f < FRAMES; ++f)
+    {
+      stage.render(in, LEDS, brights[b]);
+      for (uint8_t i = 0; i < LEDS; ++i)
+      {
+        sums[i][0] += out[i].r;
+        sums[i][1] += out[i].g;
+        sums[i][2] += out[i].b;
+        // never more than one step above the truncated value
+        CHECK(out[i].r - (int)exact(in[i].r, brights[b]) <= 1);
+      }
+    }
+    for (uint8_t i = 0; i < LEDS; ++i)
+    {
+      CHECK_NEAR(sums[i][0] / (double)FRAMES, exact(in[i].r, brights[b]), 1.0 / FRAMES);
+      CHECK_NEAR(sums[i][1] / (double)FRAMES, exact(in[i].g, brights[b]), 1.0 / FRAMES);
+      CHECK_NEAR(sums[i][2] / (double)FRAMES, exact(in[i].b, brights[b]), 1.0 / FRAMES);
+    }
+  }
+}
+
+TEST(dim_value_is_not_lost)
+{
+  LED in[1] = {LED(3, 3, 3)}, out[1];
+  uint8_t errors[3];
+  OutputStage stage(out, 1);
+  stage.setDitherBuffer(errors, 1);
+  uint32_t lit = 0;
+  for (uint16_t f = 0; f < FRAMES; ++f)
+  {
+    stage.render(in, 1, 20); // 3 * 21 / 256 = 0.246, 0 without dithering
+    lit += out[0].r;
+  }
+  CHECK_NEAR(lit / (double)FRAMES, exact(3, 20), 1.0 / FRAMES);
+}
+
+TEST(without_buffer_output_is_truncated)
+{
+  LED in[LEDS], out[LEDS];
+  for (uint8_t i = 0; i < LEDS; ++i) in[i] = LED(100 + i, 37 * i, 255 - i);
+  OutputStage stage(out, LEDS);
+  CHECK(!stage.isDithering());
+  for (uint8_t f = 0; f < 4; ++f)
+  {
+    stage.render(in, LEDS, 77);
+    for (uint8_t i = 0; i < LEDS; ++i) CHECK_EQ(out[i].r, (int)exact(in[i].r, 77));
+  }
+}
+
+TEST(strip_sends_every_dithered_frame)
+{
+  host::reset();
+  LED leds[LEDS], out[LEDS];
+  uint8_t errors[LEDS * 3];
+  for (uint8_t i = 0; i < LEDS; ++i) leds[i] = LED(50, 50, 50);
+  OutputStage stage(out, LEDS);
+  stage.setDitherBuffer(errors, LEDS);
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  strip.setChangeTracking(true);
+  strip.setOutputStage(&stage);
+  strip.setBrightness(40);
+
+  uint32_t sum = 0;
+  for (uint16_t f = 0; f < FRAMES; ++f)
+  {
+    strip.show(); // unchanged buffer, sent anyway to move the dither
+    uint8_t wire[LEDS * 3];
+    CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), LEDS * 3);
+    sum += wire[0];
+  }
+  CHECK_EQ(strip.framesSent(), FRAMES);
+  CHECK_NEAR(sum / (double)FRAMES, exact(50, 40), 1.0 / FRAMES);
+}
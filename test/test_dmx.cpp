@@ -0,0 +1,286 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+#include "dmx.hpp"
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace WS2812B;
+
+// E1.31 / Art-Net packets sent over loopback UDP to the receiver socket
+#define PORT 45568
+#define PIN 11
+#define LEDS 20 // 10 LEDs per universe
+
+static uint8_t packet[WS2812B_DMX_PACKET_SIZE];
+
+static void put16(uint8_t* p, uint16_t v)
+{
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+  put16(p, (uint16_t)(v >> 16));
+  put16(p + 2, (uint16_t)v);
+}
+
+static uint16_t e131Data(uint16_t universe, uint8_t sequence, const uint8_t* slots, uint16_t count, uint16_t sync_address)
+{
+  static const char id[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+  memset(packet, 0, 126);
+  put16(packet, 0x0010);
+  memcpy(packet + 4, id, sizeof(id));
+  put32(packet + 18, 0x04);
+  put32(packet + 40, 0x02);
+  put16(packet + 109, sync_address);
+  packet[111] = sequence;
+  put16(packet + 113, universe);
+  packet[117] = 0x02;
+  packet[118] = 0xA1;
+  put16(packet + 121, 1);
+  put16(packet + 123, count + 1u);
+  memcpy(packet + 126, slots, count);
+  return 126u + count;
+}
+
+static uint16_t e131Sync(uint16_t sync_address, uint8_t sequence)
+{
+  static const char id[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+  memset(packet, 0, 49);
+  put16(packet, 0x0010);
+  memcpy(packet + 4, id, sizeof(id));
+  put32(packet + 18, 0x08);
+  put32(packet + 40, 0x01);
+  packet[44] = sequence;
+  put16(packet + 45, sync_address);
+  return 49u;
+}
+
+static uint16_t artDmx(uint16_t universe, uint8_t sequence, const uint8_t* slots, uint16_t count)
+{
+  memset(packet, 0, 18);
+  memcpy(packet, "Art-Net", 8);
+  packet[9] = 0x50; // opcode 0x5000, little endian
+  packet[11] = 14;
+  packet[12] = sequence;
+  packet[14] = (uint8_t)universe;
+  packet[15] = (uint8_t)(universe >> 8);
+  put16(packet + 16, count);
+  memcpy(packet + 18, slots, count);
+  return 18u + count;
+}
+
+static uint16_t artSync()
+{
+  memset(packet, 0, 14);
+  memcpy(packet, "Art-Net", 8);
+  packet[9] = 0x52;
+  packet[11] = 14;
+  return 14u;
+}
+
+struct Sender
+{
+  int sock;
+  sockaddr_in to;
+
+  Sender()
+  {
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(PORT);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  }
+
+  ~Sender()
+  {
+    if (sock >= 0) close(sock);
+  }
+
+  bool send(uint16_t len)
+  {
+    return sendto(sock, packet, len, 0, (sockaddr*)&to, sizeof(to)) == len;
+  }
+};
+
+// loopback delivers right away, a few retries only guard against a slow scheduler
+static uint16_t pollAll(DMXReceiver& dmx, uint16_t expected)
+{
+  uint16_t handled = 0;
+  for (uint8_t retry = 0; retry < 100 && handled < expected; ++retry)
+  {
+    handled += dmx.poll();
+    if (handled < expected) usleep(1000);
+  }
+  return handled;
+}
+
+static void slotsFor(uint8_t* slots, uint8_t seed)
+{
+  for (uint8_t i = 0; i < 30; ++i) slots[i] = (uint8_t)(seed + i * 7u);
+}
+
+struct Rig
+{
+  LED a[LEDS / 2], b[LEDS / 2];
+  Strip strips[2];
+  StripGroup group;
+  DMXUniverse universes[2];
+
+  Rig() : strips{Strip(a, LEDS / 2, PIN), Strip(b, LEDS / 2, PIN + 1)}, group(strips, 2),
+    universes{{1, 0, 0, LEDS / 2, RGB, 0}, {2, 0, LEDS / 2, LEDS / 2, RGB, 0}}
+  {
+    group.begin();
+  }
+};
+
+static bool pixelsAre(StripGroup& group, uint32_t first, const uint8_t* slots)
+{
+  for (uint8_t i = 0; i < LEDS / 2; ++i)
+  {
+    if (group.getPixelColor(first + i) != ((uint32_t)slots[i * 3] << 16 | (uint32_t)slots[i * 3 + 1] << 8 | slots[i * 3 + 2])) return false;
+  }
+  return true;
+}
+
+TEST(e131_frame_over_udp)
+{
+  host::reset();
+  Rig rig;
+  DMXReceiver dmx(&rig.group, rig.universes, 2);
+  CHECK(dmx.begin(DMX_E131, PORT));
+  Sender tx;
+  uint8_t s1[30], s2[30];
+  slotsFor(s1, 1);
+  slotsFor(s2, 100);
+
+  CHECK(tx.send(e131Data(1, 1, s1, 30, 0)));
+  CHECK_EQ(pollAll(dmx, 1), 1);
+  CHECK_EQ(dmx.framesShown(), 0); // universe 2 missing
+  host::advance(1000);
+  CHECK(tx.send(e131Data(2, 1, s2, 30, 0)));
+  CHECK_EQ(pollAll(dmx, 1), 1);
+  CHECK_EQ(dmx.framesShown(), 1);
+  CHECK(pixelsAre(rig.group, 0, s1));
+  CHECK(pixelsAre(rig.group, LEDS / 2, s2));
+  CHECK_EQ(host::framesSent(PIN), 1);
+  CHECK_EQ(host::framesSent(PIN + 1), 1);
+
+  // from the first packet of the frame until show() returned
+  CHECK(dmx.latency() >= 1000u);
+  CHECK(dmx.latency() < 2000u);
+  CHECK_EQ(dmx.maxLatency(), dmx.latency());
+}
+
+TEST(e131_sync_holds_frame)
+{
+  host::reset();
+  Rig rig;
+  DMXReceiver dmx(&rig.group, rig.universes, 2);
+  CHECK(dmx.begin(DMX_E131, PORT));
+  Sender tx;
+  uint8_t s[30];
+  slotsFor(s, 9);
+
+  CHECK(tx.send(e131Data(1, 1, s, 30, 7000)));
+  CHECK(tx.send(e131Data(2, 1, s, 30, 7000)));
+  CHECK_EQ(pollAll(dmx, 2), 2);
+  CHECK_EQ(dmx.framesShown(), 0);
+  CHECK(tx.send(e131Sync(7000, 1)));
+  CHECK_EQ(pollAll(dmx, 1), 1);
+  CHECK_EQ(dmx.framesShown(), 1);
+}
+
+TEST(old_sequence_is_dropped)
+{
+  host::reset();
+  Rig rig;
+  DMXReceiver dmx(&rig.group, rig.universes, 2);
+  CHECK(dmx.begin(DMX_E131, PORT));
+  Sender tx;
+  uint8_t s1[30], s2[30];
+  slotsFor(s1, 1);
+  slotsFor(s2, 50);
+
+  CHECK(tx.send(e131Data(1, 10, s1, 30, 0)));
+  CHECK(tx.send(e131Data(1, 9, s2, 30, 0)));
+  CHECK_EQ(pollAll(dmx, 1), 1);
+  usleep(2000);
+  dmx.poll();
+  CHECK_EQ(dmx.packetsDropped(), 1);
+  CHECK(pixelsAre(rig.group, 0, s1));
+}
+
+TEST(artnet_frame_and_sync)
+{
+  host::reset();
+  Rig rig;
+  DMXReceiver dmx(&rig.group, rig.universes, 2);
+  CHECK(dmx.begin(DMX_ARTNET, PORT));
+  Sender tx;
+  uint8_t s1[30], s2[30];
+  slotsFor(s1, 3);
+  slotsFor(s2, 77);
+
+  CHECK(tx.send(artDmx(1, 1, s1, 30)));
+  CHECK(tx.send(artDmx(2, 1, s2, 30)));
+  CHECK_EQ(pollAll(dmx, 2), 2);
+  CHECK_EQ(dmx.framesShown(), 1);
+  CHECK(pixelsAre(rig.group, LEDS / 2, s2));
+
+  // after an ArtSync frames wait for the next one
+  CHECK(tx.send(artSync()));
+  CHECK(tx.send(artDmx(1, 2, s2, 30)));
+  CHECK(tx.send(artDmx(2, 2, s1, 30)));
+  CHECK_EQ(pollAll(dmx, 3), 3);
+  CHECK_EQ(dmx.framesShown(), 1);
+  CHECK(tx.send(artSync()));
+  CHECK_EQ(pollAll(dmx, 1), 1);
+  CHECK_EQ(dmx.framesShown(), 2);
+  CHECK(pixelsAre(rig.group, 0, s2));
+}
+
+TEST(packets_per_second)
+{
+  host::reset();
+  Rig rig;
+  DMXReceiver dmx(&rig.group, rig.universes, 2);
+  CHECK(dmx.begin(DMX_ARTNET, PORT));
+  Sender tx;
+  uint8_t s[30];
+  slotsFor(s, 5);
+
+  for (uint8_t i = 0; i < 40; ++i)
+  {
+    CHECK(tx.send(artDmx(1 + (i & 1), i + 1, s, 30)));
+    CHECK_EQ(pollAll(dmx, 1), 1);
+    host::advance(20000); // 50 packets/s, 40 within the first 800 ms
+  }
+  host::advance(1000000 - 40 * 20000);
+  CHECK(tx.send(artDmx(1, 41, s, 30)));
+  CHECK_EQ(pollAll(dmx, 1), 1);
+  CHECK_EQ(dmx.packetsPerSecond(), 40);
+  CHECK_EQ(dmx.packetsReceived(), 41);
+  CHECK_EQ(dmx.framesShown(), 20);
+}
+
+TEST(foreign_packets_are_ignored)
+{
+  host::reset();
+  Rig rig;
+  DMXReceiver dmx(&rig.group, rig.universes, 2);
+  CHECK(dmx.begin(DMX_E131, PORT));
+  Sender tx;
+  memcpy(packet, "hello", 5);
+  CHECK(tx.send(5));
+  uint8_t s[30] = {};
+  CHECK(tx.send(e131Data(3, 1, s, 30, 0))); // unmapped universe
+  usleep(2000);
+  CHECK_EQ(dmx.poll(), 0);
+  CHECK_EQ(dmx.packetsReceived(), 0);
+}
@@ -0,0 +1,178 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+#include "timing.hpp"
+
+using namespace WS2812B;
+using Loop = timing::SerialLoop<WS2812B_HOST_F_CPU>;
+
+#define PIN 6
+
+static uint64_t ns(uint32_t cycles)
+{
+  return (uint64_t)cycles * 1000000000ull / WS2812B_HOST_F_CPU;
+}
+
+TEST(loop_meets_timing_at_host_clock)
+{
+  CHECK(Loop::ok);
+}
+
+TEST(decode_round_trip_full_brightness)
+{
+  host::reset();
+  LED leds[60];
+  test::fillPattern(leds, 60, 1u);
+  show(leds, 60, PIN, 255);
+
+  uint8_t wire[180];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), 180);
+  const uint8_t* src = (const uint8_t*)leds;
+  for (uint16_t i = 0; i < 180; ++i) CHECK_EQ(wire[i], (src[i] * 255) >> 8);
+}
+
+TEST(decode_round_trip_scaled)
+{
+  host::reset();
+  LED leds[20];
+  test::fillPattern(leds, 20, 7u);
+  show(leds, 20, PIN, 40);
+
+  uint8_t wire[60];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), 60);
+  const uint8_t* src = (const uint8_t*)leds;
+  for (uint16_t i = 0; i < 60; ++i) CHECK_EQ(wire[i], (src[i] * 40) >> 8);
+}
+
+TEST(decode_round_trip_raw)
+{
+  host::reset();
+  uint8_t bytes[48];
+  for (uint8_t i = 0; i < 48; ++i) bytes[i] = i * 37u;
+  uint32_t timer = 0;
+  _extern_timer_show_raw(bytes, 48, PIN, timer);
+
+  uint8_t wire[48];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), 48);
+  for (uint8_t i = 0; i < 48; ++i) CHECK_EQ(wire[i], bytes[i]);
+}
+
+TEST(pulse_widths_follow_loop_cycles)
+{
+  host::reset();
+  uint8_t bytes[2] = {0x80, 0x00}; // 1 then seven 0, next byte all 0
+  uint32_t timer = 0;
+  _extern_timer_show_raw(bytes, 2, PIN, timer);
+
+  size_t n = 0;
+  const host::Edge* e = host::edges(PIN, n);
+  CHECK_EQ(n, 32u);
+  uint64_t t0 = e[0].time;
+  CHECK_EQ(e[1].time - t0, ns(Loop::t1h));
+  CHECK_EQ(e[2].time - t0, ns(Loop::period));
+  CHECK_EQ(e[3].time - t0, ns(Loop::period + Loop::t0h));
+  // first bit of the second byte comes after the raw loop's byte gap
+  using Raw = timing::SerialRawLoop<WS2812B_HOST_F_CPU>;
+  CHECK_EQ(e[16].time - t0, ns(8u * Raw::period + Raw::gap));
+}
+
+TEST(byte_gap_of_scaled_loop)
+{
+  host::reset();
+  LED led(0, 0, 0);
+  show(&led, 1, PIN, 255);
+
+  size_t n = 0;
+  const host::Edge* e = host::edges(PIN, n);
+  CHECK_EQ(n, 48u);
+  uint64_t t0 = e[0].time;
+  CHECK_EQ(e[16].time - t0, ns(8u * Loop::period + Loop::gap));
+  CHECK_EQ(e[32].time - t0, ns(16u * Loop::period + 2u * Loop::gap));
+}
+
+TEST(decode_rejects_long_high)
+{
+  host::reset();
+  digitalWrite(PIN, HIGH);
+  host::advanceNs(1200);
+  digitalWrite(PIN, LOW);
+  host::advance(1);
+  uint8_t wire[4];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), -1);
+}
+
+TEST(decode_rejects_low_between_bit_and_latch)
+{
+  host::reset();
+  for (uint8_t bit = 0; bit < 8; ++bit)
+  {
+    digitalWrite(PIN, HIGH);
+    host::advanceNs(400);
+    digitalWrite(PIN, LOW);
+    // 10 us after the 4th bit: too long for a bit, too short for a latch
+    host::advanceNs(bit == 3 ? 10000 : 900);
+  }
+  uint8_t wire[4];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), -1);
+}
+
+TEST(decode_accepts_hand_made_waveform)
+{
+  host::reset();
+  const uint8_t value = 0xA5;
+  for (uint8_t bit = 0; bit < 8; ++bit)
+  {
+    bool one = value & (0x80 >> bit);
+    digitalWrite(PIN, HIGH);
+    host::advanceNs(one ? 800 : 400);
+    digitalWrite(PIN, LOW);
+    host::advanceNs(one ? 450 : 850);
+  }
+  uint8_t wire[4];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), 1);
+  CHECK_EQ(wire[0], value);
+}
+
+TEST(latch_between_frames)
+{
+  host::reset();
+  LED leds[4];
+  test::fillPattern(leds, 4, 3u);
+  show(leds, 4, PIN, 255);
+  CHECK(!_extern_can_show(PIN, 0));
+  uint64_t end = host::now();
+  show(leds, 4, PIN, 255);
+  CHECK_EQ(host::latchWaits(), 1u);
+  CHECK_EQ(host::framesSent(PIN), 2u);
+
+  // the second frame starts only after the 50 us latch
+  size_t n = 0;
+  const host::Edge* e = host::edges(PIN, n);
+  CHECK_EQ(n, 2u * 192u);
+  CHECK(e[192].time >= end + 50000u);
+
+  // decode() returns the last frame only
+  uint8_t wire[12];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), 12);
+
+  host::advance(60);
+  CHECK(_extern_can_show(PIN, 0));
+  show(leds, 4, PIN, 255);
+  CHECK_EQ(host::latchWaits(), 1u);
+}
+
+TEST(strip_show_goes_through_recorder)
+{
+  host::reset();
+  LED leds[10];
+  Strip strip(leds, 10, PIN);
+  strip.begin();
+  strip.fill(0x102030);
+  strip.setBrightness(128);
+  strip.show();
+
+  uint8_t wire[30];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), 30);
+  CHECK_EQ(wire[0], (0x20 * 128) >> 8);
+  CHECK_EQ(wire[1], (0x10 * 128) >> 8);
+  CHECK_EQ(wire[2], (0x30 * 128) >> 8);
+}
@@ -0,0 +1,161 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+#include "math8.hpp"
+#include "effects.hpp"
+#include <math.h>
+
+using namespace WS2812B;
+
+TEST(scale8_against_float)
+{
+  for (int i = 0; i < 256; ++i)
+  {
+    for (int s = 0; s < 256; ++s)
+    {
+      CHECK_NEAR(scale8(i, s), i * (s + 1) / 256.0, 1.0);
+      CHECK(scale8(i, s) <= i);
+    }
+    CHECK_EQ(scale8(i, 255), i);
+    CHECK_EQ(scale8(i, 0), 0);
+  }
+}
+
+TEST(scale8_video_keeps_lit_channels)
+{
+  for (int i = 0; i < 256; ++i)
+  {
+    for (int s = 0; s < 256; ++s)
+    {
+      uint8_t v = scale8_video(i, s);
+      CHECK_NEAR(v, i * s / 256.0, 1.0);
+      CHECK_EQ(v == 0, i == 0 || s == 0);
+    }
+  }
+}
+
+TEST(qadd8_qsub8_saturate)
+{
+  for (int i = 0; i < 256; ++i)
+  {
+    for (int j = 0; j < 256; ++j)
+    {
+      CHECK_EQ(qadd8(i, j), i + j > 255 ? 255 : i + j);
+      CHECK_EQ(qsub8(i, j), i > j ? i - j : 0);
+    }
+  }
+}
+
+TEST(lerp8_against_float)
+{
+  for (int a = 0; a < 256; a += 5)
+  {
+    for (int b = 0; b < 256; b += 3)
+    {
+      CHECK_EQ(lerp8(a, b, 0), a);
+      CHECK_EQ(lerp8(a, b, 255), b);
+      for (int f = 0; f < 256; ++f) CHECK_NEAR(lerp8(a, b, f), a + (b - a) * (f + 1) / 256.0, 1.0);
+    }
+  }
+}
+
+TEST(sin8_against_float)
+{
+  for (int t = 0; t < 256; ++t) CHECK_NEAR(sin8(t), 128.0 + 127.0 * sin(2.0 * M_PI * t / 256.0), 0.5);
+  CHECK_EQ(sin8(0), 128);
+  CHECK_EQ(sin8(64), 255);
+  CHECK_EQ(sin8(192), 1);
+  CHECK_EQ(cos8(0), 255);
+}
+
+// balance and brightness are fractions of 256 with 255 as identity, like scale8. The LUT
+// truncates twice (the combined factor, then the value), so it may be below by less than 2.
+static bool nearExpected(uint8_t out, int v, int balance, int bright)
+{
+  double e = v * (balance + 1) / 256.0 * (bright + 1) / 256.0;
+  return out <= e && out > e - 2.0;
+}
+
+TEST(output_lut_against_float)
+{
+  static LED in[256], out[256];
+  for (int i = 0; i < 256; ++i) in[i] = LED(i, i, i);
+  OutputStage stage(out, 256);
+  for (int balance = 0; balance < 256; balance += 5)
+  {
+    stage.setWhiteBalance(balance, 255 - balance, balance / 2);
+    for (int bright = 0; bright < 256; ++bright)
+    {
+      stage.render(in, 256, (uint8_t)bright);
+      for (int i = 0; i < 256; ++i)
+      {
+        CHECK(nearExpected(out[i].r, i, balance, bright));
+        CHECK(nearExpected(out[i].g, i, 255 - balance, bright));
+        CHECK(nearExpected(out[i].b, i, balance / 2, bright));
+      }
+    }
+  }
+}
+
+TEST(output_lut_bright_zero_is_black)
+{
+  static LED in[256], out[256];
+  for (int i = 0; i < 256; ++i) in[i] = LED(i, i, i);
+  OutputStage stage(out, 256);
+  stage.setWhiteBalance(0xFFB0F0ul);
+  stage.render(in, 256, 0);
+  for (int i = 0; i < 256; ++i)
+  {
+    CHECK_EQ(out[i].r, 0);
+    CHECK_EQ(out[i].g, 0);
+    CHECK_EQ(out[i].b, 0);
+  }
+}
+
+TEST(output_lut_identity)
+{
+  static LED in[256], out[256];
+  for (int i = 0; i < 256; ++i) in[i] = LED(i, 255 - i, i / 3);
+  OutputStage stage(out, 256);
+  stage.render(in, 256, 255);
+  for (int i = 0; i < 256; ++i)
+  {
+    CHECK_EQ(out[i].r, in[i].r);
+    CHECK_EQ(out[i].g, in[i].g);
+    CHECK_EQ(out[i].b, in[i].b);
+  }
+}
+
+TEST(hsv_stepper_follows_saturation_and_value)
+{
+  HSVStepper stepper(0u, 97, 255u, 255u);
+  stepper.setSaturation(180u);
+  stepper.setValue(90u);
+  CHECK_EQ(stepper.getSaturation(), 180);
+  CHECK_EQ(stepper.getValue(), 90);
+  for (uint16_t i = 0; i < 2000; ++i)
+  {
+    Color c = stepper.next();
+    Color e = hsv((uint16_t)(i * 97u), 180u, 90u);
+    CHECK_NEAR(c.r, e.r, 1.0);
+    CHECK_NEAR(c.g, e.g, 1.0);
+    CHECK_NEAR(c.b, e.b, 1.0);
+  }
+}
+
+TEST(noise8_stays_between_lattice_values)
+{
+  for (uint16_t i = 0; i < 256; ++i)
+  {
+    uint8_t a = noise8(i << 8);
+    uint8_t b = noise8(((i + 1u) & 255u) << 8);
+    uint8_t last = a;
+    for (uint16_t f = 1; f < 256; ++f)
+    {
+      uint8_t v = noise8((i << 8) | f);
+      CHECK(v >= (a < b ? a : b) && v <= (a < b ? b : a));
+      // smoothstep, monotonic from a to b
+      CHECK(a <= b ? v >= last : v <= last);
+      last = v;
+    }
+  }
+}
@@ -0,0 +1,88 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+#define PIN 7
+#define R 0xC8
+#define G 0x5A
+#define B 0x14
+
+// wire bytes of OrderedLED<O>{R, G, B} in the order of the chip
+template <ColorOrder O>
+static bool sendsInOrder(const uint8_t (&expected)[4])
+{
+  host::reset();
+  OrderedLED<O> leds[2] = {OrderedLED<O>(R, G, B), OrderedLED<O>(0x010203ul)};
+  show(leds, 2, PIN, 255);
+
+  const uint8_t size = Layout<O>::size;
+  uint8_t wire[8];
+  if (host::decode(PIN, wire, sizeof(wire)) != 2 * size) return false;
+  for (uint8_t i = 0; i < size; ++i)
+  {
+    if (wire[i] != (uint8_t)((expected[i] * 255) >> 8)) return false;
+  }
+  return true;
+}
+
+TEST(three_byte_orders)
+{
+  CHECK((sendsInOrder<GRB>({G, R, B, 0})));
+  CHECK((sendsInOrder<RGB>({R, G, B, 0})));
+  CHECK((sendsInOrder<BRG>({B, R, G, 0})));
+  CHECK((sendsInOrder<RBG>({R, B, G, 0})));
+  CHECK((sendsInOrder<GBR>({G, B, R, 0})));
+  CHECK((sendsInOrder<BGR>({B, G, R, 0})));
+}
+
+// white = min(r, g, b) moves to the fourth byte
+TEST(rgbw_orders_extract_white)
+{
+  CHECK((sendsInOrder<GRBW>({G - B, R - B, 0, B})));
+  CHECK((sendsInOrder<RGBW>({R - B, G - B, 0, B})));
+}
+
+TEST(rgbw_round_trip_to_led)
+{
+  OrderedLED<GRBW> p(R, G, B);
+  CHECK_EQ(p.white(), B);
+  LED led = p;
+  CHECK_EQ(led.r, R);
+  CHECK_EQ(led.g, G);
+  CHECK_EQ(led.b, B);
+
+  OrderedLED<RGB> q;
+  q.setRGBW(10, 20, 250, 10);
+  CHECK_EQ(q.red(), 20);
+  CHECK_EQ(q.blue(), 255);
+}
+
+TEST(free_show_keeps_latch_per_pin)
+{
+  host::reset();
+  OrderedLED<RGB> leds[4];
+  show(leds, 4, 2, 255);
+  uint32_t sent = pinTimer(2);
+  CHECK_EQ(sent, micros());
+  show(leds, 4, 3, 255);
+  CHECK_EQ(pinTimer(2), sent);
+  CHECK_EQ(pinTimer(3), micros());
+  CHECK(&pinTimer(2) != &pinTimer(3));
+}
+
+TEST(pin_timers_reuse_least_recent)
+{
+  host::reset();
+  OrderedLED<RGB> leds[1];
+  for (uint8_t p = 20; p < 20 + WS2812B_PIN_TIMERS; ++p)
+  {
+    show(leds, 1, p, 255);
+    host::advance(100);
+  }
+  uint32_t* newest = &pinTimer(20 + WS2812B_PIN_TIMERS - 1);
+  uint32_t* oldest = &pinTimer(20);
+  uint32_t* next = &pinTimer(20 + WS2812B_PIN_TIMERS);
+  CHECK(next == oldest);
+  CHECK(next != newest);
+}
@@ -0,0 +1,201 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+#include "timing.hpp"
+
+using namespace WS2812B;
+using Loop = timing::ParallelLoop<WS2812B_HOST_F_CPU>;
+
+// the host groups pins in ports of 8: 0-7, 8-15, ...
+#define LEDS 4
+
+static uint64_t startOf(uint8_t pin)
+{
+  size_t n = 0;
+  const host::Edge* e = host::edges(pin, n);
+  return n ? e[0].time : 0u;
+}
+
+static uint64_t endOf(uint8_t pin)
+{
+  size_t n = 0;
+  const host::Edge* e = host::edges(pin, n);
+  return n ? e[n - 1].time : 0u;
+}
+
+static bool wireMatches(uint8_t pin, const LED* leds, uint16_t len, uint8_t bright)
+{
+  uint8_t wire[LEDS * 3];
+  if (host::decode(pin, wire, len * 3) != len * 3) return false;
+  const uint8_t* src = (const uint8_t*)leds;
+  for (uint16_t i = 0; i < len * 3; ++i)
+  {
+    if (wire[i] != (uint8_t)((src[i] * bright) >> 8)) return false;
+  }
+  return true;
+}
+
+TEST(parallel_loop_meets_timing)
+{
+  CHECK(Loop::ok);
+}
+
+TEST(transpose8_bits_to_port_values)
+{
+  const uint8_t values[3] = {0xA5, 0xFF, 0x00};
+  const uint8_t masks[3] = {0x01, 0x04, 0x80};
+  uint8_t out[8];
+  transpose8(values, masks, 3, 0x10, out);
+  for (uint8_t k = 0; k < 8; ++k)
+  {
+    uint8_t expected = 0x10 | 0x04 | (((0xA5 << k) & 0x80) ? 0x01 : 0x00);
+    CHECK_EQ(out[k], expected);
+  }
+
+  transpose8(values, masks, 0, 0x33, out);
+  for (uint8_t k = 0; k < 8; ++k) CHECK_EQ(out[k], 0x33);
+}
+
+TEST(transpose_frame_scales_and_pads)
+{
+  const uint8_t a[3] = {0xFF, 0x80, 0x01};
+  const uint8_t b[1] = {0xF0};
+  const uint8_t* bytes[2] = {a, b};
+  const uint16_t lens[2] = {3, 1};
+  const uint8_t masks[2] = {0x02, 0x40};
+  uint8_t out[25];
+  for (uint8_t i = 0; i < sizeof(out); ++i) out[i] = 0xEE;
+
+  CHECK_EQ(transposeFrame(bytes, lens, masks, 2, 255, out, sizeof(out)), 24);
+  const uint8_t scaled_a[3] = {(0xFF * 255) >> 8, (0x80 * 255) >> 8, 0};
+  const uint8_t scaled_b = (0xF0 * 255) >> 8;
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    for (uint8_t k = 0; k < 8; ++k)
+    {
+      uint8_t expected = ((scaled_a[i] << k) & 0x80) ? 0x02 : 0x00;
+      if (i == 0 && ((scaled_b << k) & 0x80)) expected |= 0x40; // b is 0 bits after its byte
+      CHECK_EQ(out[i * 8 + k], expected);
+    }
+  }
+  CHECK_EQ(out[24], 0); // read ahead by the transmit loop
+}
+
+TEST(transpose_frame_needs_room)
+{
+  const uint8_t a[2] = {1, 2};
+  const uint8_t* bytes[1] = {a};
+  const uint16_t lens[1] = {2};
+  const uint8_t masks[1] = {0x01};
+  uint8_t out[17];
+  CHECK_EQ(transposeFrame(bytes, lens, masks, 1, 255, out, 16), 0);
+  CHECK_EQ(transposeFrame(bytes, lens, masks, 1, 255, out, 17), 16);
+  CHECK_EQ(transposeFrame(bytes, lens, masks, 1, 255, nullptr, 17), 0);
+  CHECK_EQ(WS2812B_PARALLEL_BUFFER(1), 25);
+}
+
+TEST(same_port_strips_start_together)
+{
+  host::reset();
+  static LED leds[6][LEDS];
+  static uint8_t buffer[WS2812B_PARALLEL_BUFFER(LEDS)];
+  const uint8_t pins[6] = {2, 3, 5, 7, 9, 14}; // 4 on port 0, 2 on port 1
+  Strip strips[6];
+  for (uint8_t s = 0; s < 6; ++s)
+  {
+    test::fillPattern(leds[s], LEDS, s + 1u);
+    strips[s] = Strip(leds[s], LEDS, pins[s]);
+  }
+  StripGroup group(strips, 6);
+  group.begin();
+  group.setParallelBuffer(buffer, sizeof(buffer));
+  group.setBrightness(200);
+  group.show();
+
+  for (uint8_t s = 1; s < 4; ++s) CHECK_EQ(startOf(pins[s]), startOf(pins[0]));
+  CHECK_EQ(startOf(14), startOf(9));
+  CHECK(startOf(9) >= endOf(2));
+  for (uint8_t s = 0; s < 6; ++s) CHECK(wireMatches(pins[s], leds[s], LEDS, 200));
+}
+
+TEST(staged_frame_has_no_byte_gap)
+{
+  host::reset();
+  static LED a[LEDS], b[LEDS];
+  static uint8_t buffer[WS2812B_PARALLEL_BUFFER(LEDS)];
+  test::fillPattern(a, LEDS, 3u);
+  test::fillPattern(b, LEDS, 4u);
+  Strip strips[2] = {Strip(a, LEDS, 0), Strip(b, LEDS, 1)};
+  StripGroup group(strips, 2);
+  group.begin();
+  group.setParallelBuffer(buffer, sizeof(buffer));
+  group.show();
+
+  size_t n = 0;
+  const host::Edge* e = host::edges(0, n);
+  CHECK_EQ(n, LEDS * 3u * 8u * 2u);
+  uint64_t period = (uint64_t)Loop::period * 1000000000ull / WS2812B_HOST_F_CPU;
+  for (size_t i = 2; i < n; i += 2) CHECK_NEAR((double)(e[i].time - e[i - 2].time), (double)period, 1.0);
+}
+
+TEST(shorter_strip_gets_black_tail)
+{
+  host::reset();
+  static LED a[LEDS], b[1];
+  static uint8_t buffer[WS2812B_PARALLEL_BUFFER(LEDS)];
+  test::fillPattern(a, LEDS, 5u);
+  b[0] = LED(10, 20, 30);
+  Strip strips[2] = {Strip(a, LEDS, 4), Strip(b, 1, 6)};
+  StripGroup group(strips, 2);
+  group.begin();
+  group.setParallelBuffer(buffer, sizeof(buffer));
+  group.show();
+
+  uint8_t wire[LEDS * 3 + 1];
+  CHECK_EQ(host::decode(6, wire, sizeof(wire)), LEDS * 3);
+  CHECK_EQ(wire[0], (b[0].g * 255) >> 8);
+  for (uint8_t i = 3; i < LEDS * 3; ++i) CHECK_EQ(wire[i], 0);
+  CHECK(wireMatches(4, a, LEDS, 255));
+}
+
+TEST(ninth_strip_of_a_port_goes_in_next_batch)
+{
+  host::reset();
+  static LED leds[9][1];
+  static uint8_t buffer[WS2812B_PARALLEL_BUFFER(1)];
+  Strip strips[9];
+  for (uint8_t s = 0; s < 9; ++s)
+  {
+    leds[s][0] = LED(s, s, s);
+    strips[s] = Strip(leds[s], 1, 16 + (s & 7u));
+  }
+  StripGroup group(strips, 9);
+  group.begin();
+  group.setParallelBuffer(buffer, sizeof(buffer));
+  group.show();
+
+  for (uint8_t p = 17; p < 24; ++p) CHECK_EQ(host::framesSent(p), 1);
+  CHECK_EQ(host::framesSent(16), 2);
+  CHECK(wireMatches(16, leds[8], 1, 255));
+}
+
+TEST(without_buffer_strips_go_one_by_one)
+{
+  host::reset();
+  static LED a[LEDS], b[LEDS];
+  test::fillPattern(a, LEDS, 6u);
+  test::fillPattern(b, LEDS, 7u);
+  Strip strips[2] = {Strip(a, LEDS, 0), Strip(b, LEDS, 1)};
+  StripGroup group(strips, 2);
+  group.begin();
+  group.show();
+  CHECK(startOf(1) >= endOf(0));
+  CHECK(wireMatches(0, a, LEDS, 255));
+  CHECK(wireMatches(1, b, LEDS, 255));
+
+  // too small for the longest strip
+  static uint8_t buffer[WS2812B_PARALLEL_BUFFER(LEDS) - 1];
+  host::reset();
+  group.setParallelBuffer(buffer, sizeof(buffer));
+  group.show();
+  CHECK(startOf(1) >= endOf(0));
+}
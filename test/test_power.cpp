@@ -0,0 +1,100 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+#define PIN 6
+#define LEDS 10
+
+// 10 LEDs * 1 mA idle, white is 3 * 20 mA per LED scaled by (b / 256)
+static uint32_t current(uint32_t channel_sum, uint8_t b)
+{
+  return LEDS + ((channel_sum * 20u / 255u * b) >> 8);
+}
+
+static void fillGray(LED* leds, uint8_t v)
+{
+  for (uint8_t i = 0; i < LEDS; ++i) leds[i] = LED(v, v, v);
+}
+
+TEST(estimate_of_known_frames)
+{
+  host::reset();
+  LED leds[LEDS];
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  strip.setPowerBudget(1000);
+
+  fillGray(leds, 0);
+  strip.show();
+  CHECK_EQ(strip.getEstimatedCurrent(), LEDS);
+  CHECK_EQ(strip.getAppliedBrightness(), 255);
+
+  fillGray(leds, 255);
+  strip.show();
+  CHECK_EQ(strip.getEstimatedCurrent(), current(LEDS * 765u, 255));
+}
+
+TEST(budget_limits_brightness)
+{
+  host::reset();
+  LED leds[LEDS];
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  strip.setPowerBudget(310);
+  fillGray(leds, 255);
+  strip.show();
+  CHECK_EQ(strip.getAppliedBrightness(), 128); // (300 mA << 8) / 600 mA
+  CHECK_EQ(strip.getEstimatedCurrent(), 310);
+
+  uint8_t wire[LEDS * 3];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), LEDS * 3);
+  CHECK_EQ(wire[0], (255 * 128) >> 8);
+}
+
+TEST(direct_writes_without_tracking)
+{
+  host::reset();
+  LED leds[LEDS];
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  strip.setPowerBudget(1000);
+
+  fillGray(leds, 0);
+  strip.show();
+  CHECK_EQ(strip.getEstimatedCurrent(), LEDS);
+
+  // straight into the buffer, the strip does not see it
+  fillGray(leds, 255);
+  strip.show();
+  CHECK_EQ(strip.getEstimatedCurrent(), current(LEDS * 765u, 255));
+
+  fillGray(leds, 51);
+  strip.show();
+  CHECK_EQ(strip.getEstimatedCurrent(), current(LEDS * 153u, 255));
+}
+
+TEST(tracking_reuses_sum_of_unchanged_frame)
+{
+  host::reset();
+  LED leds[LEDS];
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  strip.setChangeTracking(true);
+  strip.setPowerBudget(1000);
+
+  fillGray(leds, 255);
+  strip.markDirty();
+  strip.show();
+  CHECK_EQ(strip.getEstimatedCurrent(), current(LEDS * 765u, 255));
+  CHECK_EQ(strip.framesSent(), 1);
+
+  strip.show();
+  CHECK_EQ(strip.framesSkipped(), 1);
+  CHECK_EQ(strip.getEstimatedCurrent(), current(LEDS * 765u, 255));
+
+  strip.setPixelColor(0, 0u);
+  strip.show();
+  CHECK_EQ(strip.framesSent(), 2);
+  CHECK_EQ(strip.getEstimatedCurrent(), current((LEDS - 1) * 765u, 255));
+}
@@ -0,0 +1,214 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+#include <driver/rmt.h>
+#include "rmt.hpp"
+
+using namespace WS2812B;
+
+// esp32.cpp assigns channels in order of first use, find the one driving pin
+static rmt_channel_t channelOf(uint8_t pin)
+{
+  for (int c = 0; c < RMT_CHANNEL_MAX; ++c)
+  {
+    const rmt_stub::Channel& ch = rmt_stub::channel((rmt_channel_t)c);
+    if (ch.installed && ch.gpio == pin) return (rmt_channel_t)c;
+  }
+  return RMT_CHANNEL_MAX;
+}
+
+// items back to bytes, every item has to be exactly BIT0 or BIT1
+static size_t decodeItems(const rmt_stub::Channel& ch, uint8_t* out, size_t max)
+{
+  if (ch.item_count % 8 != 0) return 0;
+  size_t n = ch.item_count / 8;
+  if (n > max) n = max;
+  for (size_t i = 0; i < n; ++i)
+  {
+    uint8_t b = 0;
+    for (uint8_t bit = 0; bit < 8; ++bit)
+    {
+      uint32_t v = ch.items[i * 8 + bit].val;
+      if (v != rmt::BIT0 && v != rmt::BIT1) return 0;
+      b = (uint8_t)((b << 1) | (v == rmt::BIT1));
+    }
+    out[i] = b;
+  }
+  return n;
+}
+
+static uint8_t done_pin = 0;
+static uint8_t done_calls = 0;
+
+static void onDone(uint8_t pin)
+{
+  done_pin = pin;
+  ++done_calls;
+}
+
+TEST(ticks_at_25ns)
+{
+  CHECK_EQ(rmt::nsToTicks(400), 16);
+  CHECK_EQ(rmt::nsToTicks(800), 32);
+  CHECK_EQ(rmt::nsToTicks(450), 18);
+  CHECK_EQ(rmt::nsToTicks(850), 34);
+  CHECK_EQ(rmt::nsToTicks(12), 0);
+  CHECK_EQ(rmt::nsToTicks(13), 1);
+}
+
+TEST(bit_items_match_rmt_item32_layout)
+{
+  rmt_item32_t item;
+  item.val = rmt::BIT0;
+  CHECK_EQ(item.duration0, 16);
+  CHECK_EQ(item.level0, 1);
+  CHECK_EQ(item.duration1, 34);
+  CHECK_EQ(item.level1, 0);
+  item.val = rmt::BIT1;
+  CHECK_EQ(item.duration0, 32);
+  CHECK_EQ(item.level0, 1);
+  CHECK_EQ(item.duration1, 18);
+  CHECK_EQ(item.level1, 0);
+}
+
+TEST(encode_scales_bytes)
+{
+  const uint8_t src[2] = {0xA5, 0xFF};
+  rmt_item32_t items[16];
+  size_t num = 0;
+  CHECK_EQ(rmt::encode(src, 2, 256u, items, 16, &num), 2);
+  CHECK_EQ(num, 16);
+  for (uint8_t i = 0; i < 8; ++i) CHECK_EQ(items[i].val, ((0xA5 >> (7 - i)) & 1) ? rmt::BIT1 : rmt::BIT0);
+
+  CHECK_EQ(rmt::encode(src + 1, 1, 128u, items, 16, &num), 1);
+  for (uint8_t i = 0; i < 8; ++i) CHECK_EQ(items[i].val, ((0x7F >> (7 - i)) & 1) ? rmt::BIT1 : rmt::BIT0);
+}
+
+TEST(encode_stops_at_wanted_num)
+{
+  const uint8_t src[4] = {1, 2, 3, 4};
+  rmt_item32_t items[32];
+  size_t num = 0;
+  CHECK_EQ(rmt::encode(src, 4, 256u, items, 23, &num), 2);
+  CHECK_EQ(num, 16);
+  CHECK_EQ(rmt::encode(src, 4, 256u, items, 7, &num), 0);
+  CHECK_EQ(num, 0);
+}
+
+TEST(encode_null_input)
+{
+  const uint8_t src[1] = {1};
+  rmt_item32_t items[8];
+  size_t num = 5;
+  CHECK_EQ(rmt::encode((const uint8_t*)nullptr, 1, 256u, items, 8, &num), 0);
+  CHECK_EQ(num, 0);
+  num = 5;
+  CHECK_EQ(rmt::encode(src, 1, 256u, (rmt_item32_t*)nullptr, 8, &num), 0);
+  CHECK_EQ(num, 0);
+}
+
+TEST(show_queues_frame_through_translator)
+{
+  LED leds[30];
+  for (uint8_t i = 0; i < 30; ++i) leds[i] = LED(i * 8u, 255 - i, i * 3u);
+  show(leds, 30, 4, 100);
+
+  rmt_channel_t c = channelOf(4);
+  CHECK(c != RMT_CHANNEL_MAX);
+  const rmt_stub::Channel& ch = rmt_stub::channel(c);
+  CHECK_EQ(ch.clk_div, WS2812B_RMT_CLK_DIV);
+  CHECK(ch.busy); // show() does not wait for the wire
+  CHECK(!_extern_can_show(4, 0));
+
+  uint8_t wire[90];
+  CHECK_EQ(decodeItems(ch, wire, sizeof(wire)), 90);
+  const uint8_t* src = (const uint8_t*)leds;
+  for (uint8_t i = 0; i < 90; ++i) CHECK_EQ(wire[i], (src[i] * 100) >> 8);
+
+  waitShowDone(4);
+  CHECK(!ch.busy);
+  CHECK(!_extern_can_show(4, 0)); // latch
+  host::advance(50);
+  CHECK(_extern_can_show(4, 0));
+}
+
+TEST(next_frame_waits_for_latch)
+{
+  LED leds[4];
+  show(leds, 4, 4, 255);
+  waitShowDone(4);
+  uint32_t end = micros();
+  show(leds, 4, 4, 255);
+  CHECK(micros() - end >= 50u);
+  waitShowDone(4);
+}
+
+TEST(show_done_callback_gets_pin)
+{
+  LED leds[8];
+  done_calls = 0;
+  onShowDone(onDone);
+  show(leds, 8, 5, 255);
+  CHECK_EQ(done_calls, 0);
+  rmt_stub::finish(channelOf(5)); // transmit end interrupt
+  CHECK_EQ(done_calls, 1);
+  CHECK_EQ(done_pin, 5);
+  onShowDone(nullptr);
+}
+
+TEST(one_channel_per_pin)
+{
+  LED leds[2];
+  show(leds, 2, 4, 255);
+  show(leds, 2, 5, 255);
+  show(leds, 2, 4, 255);
+  waitShowDone();
+  CHECK(channelOf(4) != channelOf(5));
+  int used = 0;
+  for (int c = 0; c < RMT_CHANNEL_MAX; ++c) used += rmt_stub::channel((rmt_channel_t)c).installed;
+  CHECK_EQ(used, 2);
+}
+
+// the frame on the wire stays untouched while the next one is drawn
+TEST(double_buffer_draws_while_frame_is_on_the_wire)
+{
+  LED a[4], b[4];
+  Strip strip;
+  strip.changeLEDsConfig(a, b, 4);
+  strip.setPin(12);
+  strip.begin();
+  strip.fill(0x0000FFul);
+  strip.show();
+  rmt_channel_t c = channelOf(12);
+  CHECK(rmt_stub::channel(c).busy);
+  CHECK(strip.getFrontBuffer() == b);
+
+  strip.fill(0xFF0000ul); // into a
+  CHECK(b[0] == LED(0x0000FFul));
+  uint8_t wire[12];
+  CHECK_EQ(decodeItems(rmt_stub::channel(c), wire, sizeof(wire)), 12);
+  CHECK_EQ(wire[2], (0xFF * 255) >> 8);
+  CHECK_EQ(wire[1], 0);
+
+  strip.show(); // waits for the previous frame before a goes out
+  CHECK_EQ(rmt_stub::channel(c).writes, 2);
+  CHECK_EQ(decodeItems(rmt_stub::channel(c), wire, sizeof(wire)), 12);
+  CHECK_EQ(wire[1], (0xFF * 255) >> 8);
+  waitShowDone(12);
+}
+
+// uses up the remaining channels, keep it last
+TEST(begin_fails_without_a_free_channel)
+{
+  int used = 0;
+  for (int c = 0; c < RMT_CHANNEL_MAX; ++c) used += rmt_stub::channel((rmt_channel_t)c).installed;
+  uint8_t pin = 20;
+  for (; used < WS2812B_RMT_CHANNELS; ++used, ++pin) CHECK(begin(pin));
+  CHECK(begin(20)); // already has its channel
+  CHECK(!begin(pin));
+
+  LED leds[2];
+  Strip strip(leds, 2, pin);
+  CHECK(!strip.begin());
+  show(leds, 2, pin, 255);
+  CHECK(channelOf(pin) == RMT_CHANNEL_MAX);
+}
@@ -0,0 +1,134 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+
+using namespace WS2812B;
+
+#define PIN 10
+#define LEDS 10
+
+static LED leds[LEDS];
+static uint32_t last_frame = 0;
+static bool changes = true;
+
+static bool render(uint32_t frame)
+{
+  last_frame = frame;
+  leds[0] = LED((uint8_t)frame, 0, 0);
+  return changes;
+}
+
+// runs the loop for ms milliseconds with a tick every step_us
+static void run(FrameScheduler& scheduler, uint32_t ms, uint32_t step_us)
+{
+  uint64_t end = host::now() + (uint64_t)ms * 1000000u;
+  while (host::now() < end)
+  {
+    scheduler.tick();
+    host::advance(step_us);
+  }
+}
+
+TEST(renders_at_frame_rate)
+{
+  host::reset();
+  changes = true;
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  FrameScheduler scheduler(&strip, 1, 100, render);
+
+  run(scheduler, 1000, 250);
+  CHECK_EQ(scheduler.framesRendered(), 100);
+  CHECK_EQ(scheduler.framesDropped(), 0);
+  CHECK_EQ(last_frame, 99);
+  CHECK_EQ(host::framesSent(PIN), 100);
+  CHECK_EQ(host::latchWaits(), 0); // sent only when canShow()
+}
+
+TEST(late_tick_drops_frames_and_keeps_phase)
+{
+  host::reset();
+  changes = true;
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  FrameScheduler scheduler(&strip, 1, 100, render);
+
+  CHECK(scheduler.tick()); // frame 0 due at 0 ms
+  host::advance(35000);
+  CHECK(scheduler.tick()); // due at 10 ms, 20 and 30 ms were missed
+  CHECK_EQ(scheduler.framesDropped(), 2);
+  host::advance(4000); // 39 ms
+  CHECK(!scheduler.tick());
+  host::advance(1000); // 40 ms, the old phase
+  CHECK(scheduler.tick());
+  CHECK_EQ(scheduler.framesRendered(), 3);
+}
+
+TEST(unchanged_frame_is_not_sent)
+{
+  host::reset();
+  changes = false;
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  FrameScheduler scheduler(&strip, 1, 50, render);
+
+  run(scheduler, 100, 500);
+  CHECK_EQ(scheduler.framesRendered(), 5);
+  CHECK_EQ(scheduler.framesIdle(), 5);
+  CHECK_EQ(host::framesSent(PIN), 0);
+  CHECK(!scheduler.isSending());
+}
+
+TEST(strip_in_latch_is_retried_on_next_tick)
+{
+  host::reset();
+  changes = true;
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  FrameScheduler scheduler(&strip, 1, 60, render);
+
+  strip.show(); // frame outside of the scheduler, its latch runs now
+  CHECK(scheduler.tick());
+  CHECK(scheduler.isSending());
+  CHECK_EQ(host::framesSent(PIN), 1);
+
+  host::advance(50);
+  scheduler.tick();
+  CHECK(!scheduler.isSending());
+  CHECK_EQ(host::framesSent(PIN), 2);
+  CHECK_EQ(host::latchWaits(), 0);
+  CHECK(scheduler.transmitTime() > 0);
+}
+
+TEST(group_is_sent_as_one)
+{
+  host::reset();
+  changes = true;
+  static LED other[LEDS];
+  Strip strips[2] = {Strip(leds, LEDS, PIN), Strip(other, LEDS, PIN + 1)};
+  StripGroup group(strips, 2);
+  group.begin();
+  FrameScheduler scheduler(&group, 200, render);
+
+  run(scheduler, 50, 100);
+  CHECK_EQ(scheduler.framesRendered(), 10);
+  CHECK_EQ(host::framesSent(PIN), 10);
+  CHECK_EQ(host::framesSent(PIN + 1), 10);
+}
+
+TEST(frame_rate_change_restarts_schedule)
+{
+  host::reset();
+  changes = true;
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  FrameScheduler scheduler(&strip, 1, 10, render);
+  run(scheduler, 200, 1000);
+  CHECK_EQ(scheduler.framesRendered(), 2);
+
+  scheduler.resetStats();
+  scheduler.setFrameRate(100);
+  CHECK_EQ(scheduler.getFrameRate(), 100);
+  run(scheduler, 200, 1000);
+  CHECK_EQ(scheduler.framesRendered(), 20);
+  CHECK_EQ(scheduler.framesDropped(), 0);
+}
@@ -0,0 +1,169 @@
+#include "test.hpp"
+#include "ws2812b.hpp"
+#include "serial_frame.hpp"
+
+using namespace WS2812B;
+
+#define PIN 9
+#define LEDS 30
+
+static bool sameLEDs(const LED* a, const LED* b, uint16_t len)
+{
+  for (uint16_t i = 0; i < len; ++i)
+  {
+    if (a[i] != b[i]) return false;
+  }
+  return true;
+}
+
+static bool allBlack(const LED* a, uint16_t len)
+{
+  for (uint16_t i = 0; i < len; ++i)
+  {
+    if (a[i] != 0u) return false;
+  }
+  return true;
+}
+
+static uint8_t frame[serial::maxFrameSize(LEDS)];
+
+TEST(full_frame_round_trip)
+{
+  host::reset();
+  LED src[LEDS], leds[LEDS];
+  test::fillPattern(src, LEDS, 1u);
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  SerialReceiver rx(&strip);
+
+  uint32_t n = serial::encodeFull(src, LEDS, frame);
+  CHECK_EQ(n, serial::maxFrameSize(LEDS));
+  CHECK_EQ(rx.feed(frame, n), 1);
+  CHECK(sameLEDs(leds, src, LEDS));
+  CHECK_EQ(host::framesSent(PIN), 1);
+
+  uint8_t wire[LEDS * 3];
+  CHECK_EQ(host::decode(PIN, wire, sizeof(wire)), LEDS * 3);
+  CHECK_EQ(wire[0], (src[0].g * 255) >> 8);
+}
+
+TEST(rle_and_delta_frames)
+{
+  host::reset();
+  LED src[LEDS], prev[LEDS], leds[LEDS];
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  SerialReceiver rx(&strip);
+
+  fill(src, LEDS, 0x102030ul);
+  fillFromTo(src, LEDS, 0xFF0000ul, 10, 19);
+  uint32_t n = serial::encode(nullptr, src, LEDS, frame);
+  CHECK(n < serial::encodeFull(src, LEDS, nullptr)); // runs are smaller
+  CHECK_EQ(rx.feed(frame, n), 1);
+  CHECK(sameLEDs(leds, src, LEDS));
+
+  for (uint16_t i = 0; i < LEDS; ++i) prev[i] = src[i];
+  src[3] = LED(1, 2, 3);
+  src[25] = LED(4, 5, 6);
+  n = serial::encode(prev, src, LEDS, frame);
+  CHECK_EQ(frame[2], WS2812B_SERIAL_DELTA);
+  CHECK_EQ(rx.feed(frame, n), 1);
+  CHECK(sameLEDs(leds, src, LEDS));
+  CHECK_EQ(rx.framesShown(), 2);
+}
+
+TEST(bad_checksum_clears_buffer)
+{
+  host::reset();
+  LED src[LEDS], leds[LEDS];
+  test::fillPattern(src, LEDS, 2u);
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  SerialReceiver rx(&strip);
+
+  uint32_t n = serial::encodeFull(src, LEDS, frame);
+  frame[10] ^= 0x01; // payload byte
+  CHECK_EQ(rx.feed(frame, n), 0);
+  CHECK_EQ(rx.framesBad(), 1);
+  CHECK_EQ(host::framesSent(PIN), 0);
+  CHECK(allBlack(leds, LEDS));
+
+  // delta frames have no base until the next key frame
+  LED next[LEDS];
+  for (uint16_t i = 0; i < LEDS; ++i) next[i] = src[i];
+  next[0] = LED(9, 9, 9);
+  n = serial::encodeDelta(src, next, LEDS, frame);
+  CHECK_EQ(rx.feed(frame, n), 0);
+  CHECK_EQ(rx.framesSkipped(), 1);
+
+  n = serial::encodeFull(next, LEDS, frame);
+  CHECK_EQ(rx.feed(frame, n), 1);
+  CHECK(sameLEDs(leds, next, LEDS));
+}
+
+TEST(checksum_sums_mod_256)
+{
+  LED src[2] = {LED(0xFF, 0xFF, 0xFF), LED(0xFF, 0xFF, 0xFF)};
+  uint32_t n = serial::encodeFull(src, 2, frame);
+  uint8_t sum1 = 0, sum2 = 0;
+  for (uint32_t i = 6; i < n - 2; ++i)
+  {
+    sum1 = (uint8_t)(sum1 + frame[i]);
+    sum2 = (uint8_t)(sum2 + sum1);
+  }
+  CHECK_EQ(frame[n - 2], sum1);
+  CHECK_EQ(frame[n - 1], sum2);
+  CHECK_EQ(sum1, (6 * 0xFF) % 256);
+}
+
+TEST(resyncs_after_garbage)
+{
+  host::reset();
+  LED src[LEDS], leds[LEDS];
+  test::fillPattern(src, LEDS, 3u);
+  Strip strip(leds, LEDS, PIN);
+  strip.begin();
+  SerialReceiver rx(&strip);
+
+  const uint8_t garbage[6] = {'W', 'x', 'W', 'S', 'F', 0x00};
+  CHECK_EQ(rx.feed(garbage, sizeof(garbage)), 0);
+  rx.reset();
+  uint32_t n = serial::encodeFull(src, LEDS, frame);
+  CHECK_EQ(rx.feed(frame, n), 1);
+  CHECK(sameLEDs(leds, src, LEDS));
+}
+
+TEST(adalight_frame)
+{
+  host::reset();
+  LED leds[4];
+  Strip strip(leds, 4, PIN);
+  strip.begin();
+  SerialReceiver rx(&strip);
+
+  // n + 1 pixels, r g b
+  const uint8_t ada[6 + 12] = {'A', 'd', 'a', 0, 3, 0 ^ 3 ^ 0x55, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  CHECK_EQ(rx.feed(ada, sizeof(ada)), 1);
+  CHECK(leds[0] == LED(1, 2, 3));
+  CHECK(leds[3] == LED(10, 11, 12));
+}
+
+TEST(delta_frames_stop_at_15_bit_starts)
+{
+  static LED prev[WS2812B_SERIAL_DELTA_MAX + 1u];
+  static LED leds[WS2812B_SERIAL_DELTA_MAX + 1u];
+  static uint8_t out[serial::maxFrameSize(WS2812B_SERIAL_DELTA_MAX + 1u)];
+
+  // the last LED a span can start at
+  leds[WS2812B_SERIAL_DELTA_MAX - 1u] = LED(1u, 2u, 3u);
+  CHECK(serial::encode(prev, leds, WS2812B_SERIAL_DELTA_MAX, out) > 0u);
+  CHECK_EQ(out[2], WS2812B_SERIAL_DELTA);
+  CHECK_EQ(out[6], 0x7F);
+  CHECK_EQ(out[7], 0xFF);
+
+  // one more LED would set the run flag, the frame goes out as full or RLE
+  leds[WS2812B_SERIAL_DELTA_MAX] = LED(4u, 5u, 6u);
+  CHECK_EQ(serial::encodeDelta(prev, leds, WS2812B_SERIAL_DELTA_MAX + 1u, out), 0u);
+  CHECK(serial::encode(prev, leds, WS2812B_SERIAL_DELTA_MAX + 1u, out) > 0u);
+  CHECK(out[2] != WS2812B_SERIAL_DELTA);
+}
@@ -0,0 +1,69 @@
+#include "test.hpp"
+#include "timing.hpp"
+
+using namespace WS2812B::timing;
+
+template <typename LOOP>
+static void checkLoop(uint32_t f_cpu)
+{
+  CHECK(LOOP::ok);
+  CHECK(within(nanos(LOOP::t0h, f_cpu), T0H_MIN, T0H_MAX));
+  CHECK(within(nanos(LOOP::t1h, f_cpu), T1H_MIN, T1H_MAX));
+  CHECK(nanos(LOOP::t0l, f_cpu) >= T0L_MIN);
+  CHECK(nanos(LOOP::t1l, f_cpu) >= T1L_MIN);
+  CHECK(nanos(LOOP::t0l + LOOP::gap, f_cpu) <= TL_MAX);
+}
+
+template <uint32_t F>
+static void checkClock()
+{
+  checkLoop<SerialLoop<F>>(F);
+  checkLoop<SerialRawLoop<F>>(F);
+  checkLoop<StaticLoop<F>>(F);
+  checkLoop<ParallelLoop<F>>(F);
+}
+
+TEST(cycle_conversion)
+{
+  CHECK_EQ(cycles(400, 16000000u), 6);
+  CHECK_EQ(cycles(800, 16000000u), 13);
+  CHECK_EQ(cycles(1250, 8000000u), 10);
+  CHECK_EQ(nanos(22, 16000000u), 1375);
+  CHECK_EQ(pad(6, 2), 4);
+  CHECK_EQ(pad(1, 2), 0);
+}
+
+TEST(loops_meet_timing_at_supported_clocks)
+{
+  checkClock<8000000u>();
+  checkClock<12000000u>();
+  checkClock<16000000u>();
+  checkClock<20000000u>();
+}
+
+TEST(loop_budget_at_16mhz)
+{
+  using L = SerialLoop<16000000u>;
+  CHECK_EQ(L::t0h, 6);
+  CHECK_EQ(L::t1h, 13);
+  CHECK_EQ(L::period, 22);
+  CHECK_EQ(L::d1, 4);
+  CHECK_EQ(nanos(L::period, 16000000u), 1375);
+}
+
+// no padding left at 8 MHz, the loop overhead sets the bit time: 1.875 us, ~533 kbit/s
+TEST(loop_budget_at_8mhz)
+{
+  using L = SerialLoop<8000000u>;
+  CHECK_EQ(L::t0h, 3);
+  CHECK_EQ(L::t1h, 6);
+  CHECK_EQ(L::period, 15);
+  CHECK_EQ(nanos(L::period, 8000000u), 1875);
+  CHECK_EQ(ParallelLoop<8000000u>::period, 15);
+}
+
+TEST(four_mhz_is_rejected)
+{
+  CHECK(!SerialLoop<4000000u>::ok);
+  CHECK(!ParallelLoop<4000000u>::ok);
+}